@@ -10,4 +10,10 @@
 
 @interface Benchmark : NSObject
 + (void)benchmark;
+
+/// Runs the scenario matrix (thread sweeps, read/write mixes, value-size
+/// distributions) against YYMemoryCache with warmup and multiple timed
+/// iterations, prints p50/p95/p99 latencies plus CSV rows, and writes the
+/// results as JSON into the Documents directory for diffing across runs.
++ (void)harnessBenchmark;
 @end
@@ -12,9 +12,49 @@
 #import "YYThreadSafeDictionary.h"
 #import <QuartzCore/QuartzCore.h>
 
+typedef struct {
+    const char *name;        // scenario name
+    double readRatio;        // fraction of operations that are reads
+    int valueSizeMin;        // value size lower bound (bytes)
+    int valueSizeMax;        // value size upper bound (== min for fixed size)
+    int keySpace;            // number of distinct keys
+    int operationsPerThread; // timed operations per thread per iteration
+    int iterations;          // timed iterations
+    int warmupOperations;    // untimed operations per thread before timing
+} BenchmarkScenario;
+
+// xorshift64, one state per thread so threads never share rng state
+static inline uint64_t benchmark_rng(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static int benchmark_compare_double(const void *a, const void *b) {
+    double da = *(const double *)a, db = *(const double *)b;
+    if (da < db) return -1;
+    if (da > db) return 1;
+    return 0;
+}
+
+// nearest-rank percentile on a sorted array, in microseconds
+static double benchmark_percentile(const double *sorted, long count, double p) {
+    if (count == 0) return 0;
+    long idx = (long)(p * (count - 1) + 0.5);
+    if (idx > count - 1) idx = count - 1;
+    return sorted[idx] * 1e6;
+}
+
 @implementation Benchmark
 + (void)benchmark {
-    
+
+    @autoreleasepool {
+        [self harnessBenchmark];
+    }
+
     @autoreleasepool {
         [self memoryCacheBenchmark];
     }
@@ -888,5 +928,138 @@
 }
 
 
++ (void)harnessBenchmark {
+    BenchmarkScenario scenarios[] = {
+        // name              read   vmin    vmax   keys   ops/thr  iter  warmup
+        {"small_read_heavy", 0.95,    64,     64, 20000,  100000,    3,  20000},
+        {"small_mixed",      0.50,    64,     64, 20000,  100000,    3,  20000},
+        {"large_read_heavy", 0.95,  1024,  16384, 20000,   50000,    3,  10000},
+        {"large_mixed",      0.50,  1024,  16384, 20000,   50000,    3,  10000},
+    };
+    int threadSweep[] = {1, 2, 4, 8};
+    
+    NSMutableArray *jsonResults = [NSMutableArray new];
+    
+    printf("\n===========================\n");
+    printf("YYMemoryCache harness (p50/p95/p99 in us)\n\n");
+    printf("CSV,scenario,threads,read_ratio,value_min,value_max,iteration,ops,total_ms,ops_per_sec,p50_us,p95_us,p99_us,max_us\n");
+    
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+        BenchmarkScenario sc = scenarios[s];
+        for (size_t t = 0; t < sizeof(threadSweep) / sizeof(threadSweep[0]); t++) {
+            int threads = threadSweep[t];
+            @autoreleasepool {
+                [self runHarnessScenario:sc threads:threads results:jsonResults];
+            }
+        }
+    }
+    
+    NSString *docPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) firstObject];
+    NSString *jsonPath = [docPath stringByAppendingPathComponent:@"benchmark_results.json"];
+    NSData *json = [NSJSONSerialization dataWithJSONObject:jsonResults options:NSJSONWritingPrettyPrinted error:NULL];
+    if ([json writeToFile:jsonPath atomically:YES]) {
+        printf("\nJSON results written to %s\n", jsonPath.UTF8String);
+    }
+}
+
++ (void)runHarnessScenario:(BenchmarkScenario)sc threads:(int)threads results:(NSMutableArray *)results {
+    YYMemoryCache *cache = [YYMemoryCache new];
+    
+    // pregenerate keys and a pool of values so the loops measure the cache,
+    // not NSString/NSData creation
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:sc.keySpace];
+    for (int i = 0; i < sc.keySpace; i++) {
+        [keys addObject:@(i).description];
+    }
+    int valuePoolSize = 64;
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:valuePoolSize];
+    uint64_t sizeRng = 0x9E3779B97F4A7C15UL;
+    for (int i = 0; i < valuePoolSize; i++) {
+        int size = sc.valueSizeMin;
+        if (sc.valueSizeMax > sc.valueSizeMin) {
+            size += benchmark_rng(&sizeRng) % (sc.valueSizeMax - sc.valueSizeMin);
+        }
+        NSMutableData *data = [NSMutableData dataWithLength:size];
+        [values addObject:data];
+    }
+    
+    // preload so reads mostly hit
+    for (int i = 0; i < sc.keySpace; i++) {
+        [cache setObject:values[i % valuePoolSize] forKey:keys[i]];
+    }
+    
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    uint32_t readThreshold = (uint32_t)(sc.readRatio * UINT32_MAX);
+    
+    // warmup (untimed)
+    dispatch_apply(threads, queue, ^(size_t thread) {
+        uint64_t rng = 0xA0761D6478BD642FUL ^ (thread + 1);
+        for (int i = 0; i < sc.warmupOperations; i++) {
+            uint64_t r = benchmark_rng(&rng);
+            id key = keys[r % sc.keySpace];
+            if ((uint32_t)(r >> 32) < readThreshold) {
+                [cache objectForKey:key];
+            } else {
+                [cache setObject:values[r % valuePoolSize] forKey:key];
+            }
+        }
+    });
+    
+    int ops = sc.operationsPerThread;
+    double *latencies = malloc(sizeof(double) * ops * threads);
+    
+    for (int iteration = 0; iteration < sc.iterations; iteration++) {
+        NSTimeInterval begin = CACurrentMediaTime();
+        dispatch_apply(threads, queue, ^(size_t thread) {
+            uint64_t rng = 0xE7037ED1A0B428DBUL ^ ((thread + 1) * 0x2545F4914F6CDD1DUL) ^ (iteration + 1);
+            double *slice = latencies + thread * ops; // each thread owns its slice, no sync needed
+            for (int i = 0; i < ops; i++) {
+                uint64_t r = benchmark_rng(&rng);
+                id key = keys[r % sc.keySpace];
+                NSTimeInterval opBegin = CACurrentMediaTime();
+                if ((uint32_t)(r >> 32) < readThreshold) {
+                    [cache objectForKey:key];
+                } else {
+                    [cache setObject:values[r % valuePoolSize] forKey:key];
+                }
+                slice[i] = CACurrentMediaTime() - opBegin;
+            }
+        });
+        NSTimeInterval totalTime = CACurrentMediaTime() - begin;
+        
+        long totalOps = (long)ops * threads;
+        qsort(latencies, totalOps, sizeof(double), benchmark_compare_double);
+        double p50 = benchmark_percentile(latencies, totalOps, 0.50);
+        double p95 = benchmark_percentile(latencies, totalOps, 0.95);
+        double p99 = benchmark_percentile(latencies, totalOps, 0.99);
+        double max = latencies[totalOps - 1] * 1e6;
+        double opsPerSec = totalOps / totalTime;
+        
+        printf("%-18s threads:%d read:%.2f iter:%d  %8.2f ms  %10.0f ops/s  p50:%6.2f p95:%6.2f p99:%6.2f max:%8.2f\n",
+               sc.name, threads, sc.readRatio, iteration, totalTime * 1000, opsPerSec, p50, p95, p99, max);
+        printf("CSV,%s,%d,%.2f,%d,%d,%d,%ld,%.3f,%.0f,%.2f,%.2f,%.2f,%.2f\n",
+               sc.name, threads, sc.readRatio, sc.valueSizeMin, sc.valueSizeMax, iteration,
+               totalOps, totalTime * 1000, opsPerSec, p50, p95, p99, max);
+        
+        [results addObject:@{
+            @"scenario" : @(sc.name),
+            @"threads" : @(threads),
+            @"read_ratio" : @(sc.readRatio),
+            @"value_min" : @(sc.valueSizeMin),
+            @"value_max" : @(sc.valueSizeMax),
+            @"iteration" : @(iteration),
+            @"ops" : @(totalOps),
+            @"total_ms" : @(totalTime * 1000),
+            @"ops_per_sec" : @(opsPerSec),
+            @"p50_us" : @(p50),
+            @"p95_us" : @(p95),
+            @"p99_us" : @(p99),
+            @"max_us" : @(max),
+        }];
+    }
+    
+    free(latencies);
+}
+
 
 @end
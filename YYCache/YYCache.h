@@ -29,6 +29,49 @@ FOUNDATION_EXPORT const unsigned char YYCacheVersionString[];
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ Number of buckets in the latency histograms of `YYCacheStatistics`.
+ Bucket i counts lookups that took between 2^i and 2^(i+1) microseconds;
+ the last bucket counts everything slower.
+ `YYCacheStatistics` 耗时直方图的分桶数量
+ 桶i统计耗时在 2^i 到 2^(i+1) 微秒之间的查询，最后一个桶统计所有更慢的查询
+ */
+enum { YYCacheLatencyBucketCount = 16 };
+
+/**
+ A snapshot of the counters and latency histograms maintained by a cache.
+ See `statistics`.
+ 缓存运行计数和耗时直方图的快照，见 `statistics`
+ */
+typedef struct YYCacheStatistics {
+    YYMemoryCacheStatistics memory; ///< Counters of the memory tier. 内存层的计数
+    YYDiskCacheStatistics disk;     ///< Counters of the disk tier. 磁盘层的计数
+    uint64_t memoryHitLatency[YYCacheLatencyBucketCount];   ///< Latency histogram of memory hits. 内存命中的耗时直方图
+    uint64_t diskHitLatency[YYCacheLatencyBucketCount];     ///< Latency histogram of disk hits. 磁盘命中的耗时直方图
+    uint64_t missLatency[YYCacheLatencyBucketCount];        ///< Latency histogram of misses. 未命中的耗时直方图
+} YYCacheStatistics;
+
+
+/**
+ A handle for an in-flight prefetch started with
+ `YYCache.prefetchObjectsForKeys:`. Thread safe.
+ `YYCache.prefetchObjectsForKeys:` 返回的预取句柄，线程安全
+ */
+@interface YYCachePrefetchToken : NSObject
+
+/**
+ Cancel the prefetch. Keys not yet loaded are skipped; already loaded objects
+ stay in the memory cache. Cancelling a finished prefetch has no effect.
+ 取消预取。尚未加载的key被跳过，已经加载的对象留在内存缓存中
+ 对已完成的预取调用无效果
+ */
+- (void)cancel;
+
+/** Whether the prefetch was cancelled. 预取是否已被取消 */
+@property (readonly, getter=isCancelled) BOOL cancelled;
+
+@end
+
 
 /**
  `YYCache` is a thread safe key-value cache.
@@ -142,10 +185,82 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)objectForKey:(NSString *)key withBlock:(nullable void(^)(NSString *key, id<NSCoding> object))block;
 
+/**
+ Returns the values associated with the given keys.
+ This method may blocks the calling thread until file read finished.
+
+ @discussion The memory cache lock is taken once for the whole batch, the
+ missed keys fall through to a single batched disk query, and the disk hits
+ are backfilled into the memory cache in one pass.
+
+ @param keys An array of keys identifying the values. If empty, just return an
+     empty dictionary.
+ @return A dictionary of the keys found in cache and their values. Keys with
+     no associated value are simply absent from the result.
+ */
+- (NSDictionary<NSString *, id<NSCoding>> *)objectsForKeys:(NSArray<NSString *> *)keys;
+
+/**
+ Returns the values associated with the given keys.
+ This method returns immediately and invoke the passed block in background queue
+ when the operation finished.
+
+ @param keys  An array of keys identifying the values.
+ @param block A block which will be invoked in background queue when finished.
+ */
+- (void)objectsForKeys:(NSArray<NSString *> *)keys withBlock:(void(^)(NSDictionary<NSString *, id<NSCoding>> *objects))block;
+
+/**
+ Preloads the most recently accessed objects from the disk cache into the
+ memory cache. This method returns immediately and performs the work in a
+ background queue.
+
+ @discussion After launch the memory tier starts empty and the first screen
+ pays a disk read per entry. Calling this early during startup fetches the
+ top-N hottest keys with one ordered manifest query, deserializes them in the
+ background and populates the memory cache, so the first reads hit memory.
+
+ @param count      The maximum number of objects to preload.
+ @param completion A block invoked in background queue when the preload
+     finished, with the number of objects that were loaded. Pass nil to ignore.
+
+ 把磁盘缓存中最近访问的对象预加载进内存缓存，方法立即返回，加载在后台队列进行
+ 启动后内存缓存是空的，首屏的每条数据都要付出一次磁盘读取
+ 启动早期调用此方法：一条有序的manifest查询取出最热的N个key
+ 在后台反归档并填充内存缓存，首批读取即可命中内存
+ */
+- (void)preloadObjectsWithCount:(NSUInteger)count completion:(nullable void(^)(NSUInteger preloadedCount))completion;
+
+/**
+ Hints that the given keys are about to be needed (e.g. the next page of a
+ feed) and moves them from the disk tier into the memory tier ahead of time.
+ This method returns immediately.
+
+ @discussion The keys already in the memory cache are skipped, the rest are
+ read from disk in batches on a low-priority queue and inserted at the cold
+ end of the memory cache, so a prefetch can never displace the hot working
+ set (see `YYMemoryCache.setPrefetchedObject:forKey:withCost:`). Cancellation
+ is checked between batches, so a stale hint (the user scrolled elsewhere)
+ stops paying I/O almost immediately.
+
+ @param keys The keys expected to be needed soon.
+ @return A token that can cancel the remaining work. The token does not need
+     to be retained for the prefetch to proceed.
+
+ 提示这些key即将被用到（比如feed的下一页），提前把它们从磁盘层搬进内存层，方法立即返回
+ 已在内存缓存中的key被跳过，其余的在低优先级队列上分批读盘
+ 并插入到内存缓存的冷端，预取永远不会把热点工作集挤出缓存
+ （见 `YYMemoryCache.setPrefetchedObject:forKey:withCost:`）
+ 批与批之间检查取消状态，过时的提示（用户划走了）几乎立即停止消耗I/O
+ keys 即将用到的key数组
+ 返回可以取消剩余工作的token，不持有token预取也会正常进行
+ */
+- (YYCachePrefetchToken *)prefetchObjectsForKeys:(NSArray<NSString *> *)keys;
+
 /**
  Sets the value of the specified key in the cache.
  This method may blocks the calling thread until file write finished.
- 
+
  @param object The object to be stored in the cache. If nil, it calls `removeObjectForKey:`.
  @param key    The key with which to associate the value. If nil, this method has no effect.
  */
@@ -161,6 +276,52 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)setObject:(nullable id<NSCoding>)object forKey:(NSString *)key withBlock:(nullable void(^)(void))block;
 
+/**
+ Sets the value of the specified key in the cache with a time-to-live.
+ This method may blocks the calling thread until file write finished.
+
+ @discussion Expiration is lazy in both tiers: an expired entry is treated as a
+ miss on read and reclaimed by the periodic trim passes, so entries with very
+ different freshness needs can share one cache without extra bookkeeping.
+
+ @param object The object to be stored in the cache. If nil, it calls `removeObjectForKey:`.
+ @param key    The key with which to associate the value. If nil, this method has no effect.
+ @param ttl    Seconds until the entry expires. 0 or a negative value means no expiry.
+ */
+- (void)setObject:(nullable id<NSCoding>)object forKey:(NSString *)key withTTL:(NSTimeInterval)ttl;
+
+/**
+ Sets the value of the specified key in the cache with a time-to-live.
+ This method returns immediately and invoke the passed block in background queue
+ when the operation finished.
+
+ @param object The object to be stored in the cache. If nil, it calls `removeObjectForKey:`.
+ @param key    The key with which to associate the value. If nil, this method has no effect.
+ @param ttl    Seconds until the entry expires. 0 or a negative value means no expiry.
+ @param block  A block which will be invoked in background queue when finished.
+ */
+- (void)setObject:(nullable id<NSCoding>)object forKey:(NSString *)key withTTL:(NSTimeInterval)ttl withBlock:(nullable void(^)(void))block;
+
+/**
+ Sets the values of the specified keys in both the memory and disk cache.
+ This method may blocks the calling thread until file write finished.
+
+ @param objects An array of objects to be stored in the cache.
+ @param keys    An array of keys, must have the same count as `objects`.
+ */
+- (void)setObjects:(NSArray<id<NSCoding>> *)objects forKeys:(NSArray<NSString *> *)keys;
+
+/**
+ Sets the values of the specified keys in both the memory and disk cache.
+ This method returns immediately and invoke the passed block in background queue
+ when the operation finished.
+
+ @param objects An array of objects to be stored in the cache.
+ @param keys    An array of keys, must have the same count as `objects`.
+ @param block   A block which will be invoked in background queue when finished.
+ */
+- (void)setObjects:(NSArray<id<NSCoding>> *)objects forKeys:(NSArray<NSString *> *)keys withBlock:(nullable void(^)(void))block;
+
 /**
  Removes the value of the specified key in the cache.
  This method may blocks the calling thread until file delete finished.
@@ -205,6 +366,33 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)removeAllObjectsWithProgressBlock:(nullable void(^)(int removedCount, int totalCount))progress
                                  endBlock:(nullable void(^)(BOOL error))end;
 
+#pragma mark - Statistics
+///=============================================================================
+/// @name Statistics
+///=============================================================================
+
+/**
+ Returns a snapshot of the per-tier hit/miss/eviction/expiry counters together
+ with the lookup latency histograms, split by outcome (memory hit, disk hit,
+ miss).
+
+ @discussion All counters are maintained with relaxed atomic increments on the
+ access paths, so the instrumentation is cheap enough to leave enabled in
+ production. The histograms cover `objectForKey:` and `objectForKey:withBlock:`.
+
+ 返回各层命中/未命中/淘汰/过期计数以及按结果（内存命中/磁盘命中/未命中）
+ 区分的查询耗时直方图的快照
+ 所有计数在访问路径上用relaxed原子自增维护，开销可以忽略，适合在线上常开
+ 直方图统计 `objectForKey:` 和 `objectForKey:withBlock:`
+ */
+- (YYCacheStatistics)statistics;
+
+/**
+ Resets all statistics of both tiers to zero.
+ 将两层的所有统计计数清零
+ */
+- (void)resetStatistics;
+
 @end
 
 NS_ASSUME_NONNULL_END
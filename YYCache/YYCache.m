@@ -12,8 +12,43 @@
 #import "YYCache.h"
 #import "YYMemoryCache.h"
 #import "YYDiskCache.h"
+#import <QuartzCore/QuartzCore.h>
+#import <stdatomic.h>
 
-@implementation YYCache
+/**
+ 把一次查询耗时放进对数分桶：桶i统计耗时在 [2^i, 2^(i+1)) 微秒内的查询
+ 最后一个桶统计所有更慢的查询
+ */
+static inline NSUInteger _YYCacheLatencyBucket(NSTimeInterval seconds) {
+    uint64_t usec = (uint64_t)(seconds * 1e6);
+    NSUInteger bucket = 0;
+    while (usec > 1 && bucket + 1 < YYCacheLatencyBucketCount) {
+        usec >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+@implementation YYCachePrefetchToken {
+    atomic_bool _cancelled;
+}
+
+- (void)cancel {
+    atomic_store_explicit(&_cancelled, true, memory_order_relaxed);
+}
+
+- (BOOL)isCancelled {
+    return atomic_load_explicit(&_cancelled, memory_order_relaxed);
+}
+
+@end
+
+
+@implementation YYCache {
+    atomic_uint_fast64_t _memoryHitLatency[YYCacheLatencyBucketCount];  /// 内存命中的耗时直方图
+    atomic_uint_fast64_t _diskHitLatency[YYCacheLatencyBucketCount];    /// 磁盘命中的耗时直方图
+    atomic_uint_fast64_t _missLatency[YYCacheLatencyBucketCount];       /// 未命中的耗时直方图
+}
 
 - (instancetype) init {
     NSLog(@"Use \"initWithName\" or \"initWithPath\" to create YYCache instance.");
@@ -67,20 +102,28 @@
 }
 
 - (id<NSCoding>)objectForKey:(NSString *)key {
+    NSTimeInterval begin = CACurrentMediaTime();
     id<NSCoding> object = [_memoryCache objectForKey:key];
-    if (!object) {
-        object = [_diskCache objectForKey:key];
-        if (object) {
-            [_memoryCache setObject:object forKey:key];
-        }
+    if (object) {
+        [self _recordLatencySince:begin inHistogram:_memoryHitLatency];
+        return object;
+    }
+    object = [_diskCache objectForKey:key];
+    if (object) {
+        [_memoryCache setObject:object forKey:key];
+        [self _recordLatencySince:begin inHistogram:_diskHitLatency];
+    } else {
+        [self _recordLatencySince:begin inHistogram:_missLatency];
     }
     return object;
 }
 
 - (void)objectForKey:(NSString *)key withBlock:(void (^)(NSString *key, id<NSCoding> object))block {
     if (!block) return;
+    NSTimeInterval begin = CACurrentMediaTime();
     id<NSCoding> object = [_memoryCache objectForKey:key];
     if (object) {
+        [self _recordLatencySince:begin inHistogram:_memoryHitLatency];
         dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
             block(key, object);
         });
@@ -89,16 +132,129 @@
             if (object && ![_memoryCache objectForKey:key]) {
                 [_memoryCache setObject:object forKey:key];
             }
+            // 异步查询的耗时包含排队时间，反映调用方感知到的延迟
+            [self _recordLatencySince:begin inHistogram:object ? _diskHitLatency : _missLatency];
             block(key, object);
         }];
     }
 }
 
+- (NSDictionary<NSString *, id<NSCoding>> *)objectsForKeys:(NSArray<NSString *> *)keys {
+    if (keys.count == 0) return [NSDictionary dictionary];
+    NSMutableDictionary *result = [[_memoryCache objectsForKeys:keys] mutableCopy];
+    if (result.count < keys.count) {
+        NSMutableArray *missedKeys = [NSMutableArray new];
+        for (NSString *key in keys) {
+            if (!result[key]) [missedKeys addObject:key];
+        }
+        NSDictionary *diskObjects = [_diskCache objectsForKeys:missedKeys];
+        if (diskObjects.count) {
+            // 磁盘命中的对象一次性回填到内存缓存
+            // allKeys/allValues的枚举顺序没有对应保证，成对数组要在一次枚举里构建
+            NSMutableArray *backfillKeys = [NSMutableArray arrayWithCapacity:diskObjects.count];
+            NSMutableArray *backfillObjects = [NSMutableArray arrayWithCapacity:diskObjects.count];
+            [diskObjects enumerateKeysAndObjectsUsingBlock:^(NSString *key, id object, BOOL *stop) {
+                [backfillKeys addObject:key];
+                [backfillObjects addObject:object];
+            }];
+            [_memoryCache setObjects:backfillObjects forKeys:backfillKeys];
+            [result addEntriesFromDictionary:diskObjects];
+        }
+    }
+    return result;
+}
+
+- (void)objectsForKeys:(NSArray<NSString *> *)keys withBlock:(void(^)(NSDictionary<NSString *, id<NSCoding>> *objects))block {
+    if (!block) return;
+    __weak typeof(self) _self = self;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        __strong typeof(_self) self = _self;
+        NSDictionary *objects = self ? [self objectsForKeys:keys] : [NSDictionary dictionary];
+        block(objects);
+    });
+}
+
 - (void)setObject:(id<NSCoding>)object forKey:(NSString *)key {
     [_memoryCache setObject:object forKey:key];
     [_diskCache setObject:object forKey:key];
 }
 
+- (void)setObject:(id<NSCoding>)object forKey:(NSString *)key withTTL:(NSTimeInterval)ttl {
+    [_memoryCache setObject:object forKey:key withCost:0 ttl:ttl];
+    [_diskCache setObject:object forKey:key withTTL:ttl];
+}
+
+- (void)setObject:(id<NSCoding>)object forKey:(NSString *)key withTTL:(NSTimeInterval)ttl withBlock:(void(^)(void))block {
+    // 和 `setObject:forKey:withBlock:` 一致：内存缓存同步写入，返回后立即可读，只有磁盘写入异步
+    [_memoryCache setObject:object forKey:key withCost:0 ttl:ttl];
+    __weak typeof(self) _self = self;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        __strong typeof(_self) self = _self;
+        if (self) [self->_diskCache setObject:object forKey:key withTTL:ttl];
+        if (block) block();
+    });
+}
+
+- (void)preloadObjectsWithCount:(NSUInteger)count completion:(void(^)(NSUInteger preloadedCount))completion {
+    __weak typeof(self) _self = self;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        __strong typeof(_self) self = _self;
+        if (!self) {
+            if (completion) completion(0);
+            return;
+        }
+        // 磁盘上最近访问的对象就是下次启动最可能用到的对象
+        NSDictionary *objects = [self->_diskCache objectsOrderByAccessTimeDescWithCount:count];
+        if (objects.count) {
+            // allKeys/allValues的枚举顺序没有对应保证，成对数组要在一次枚举里构建
+            NSMutableArray *preloadKeys = [NSMutableArray arrayWithCapacity:objects.count];
+            NSMutableArray *preloadObjects = [NSMutableArray arrayWithCapacity:objects.count];
+            [objects enumerateKeysAndObjectsUsingBlock:^(NSString *key, id object, BOOL *stop) {
+                [preloadKeys addObject:key];
+                [preloadObjects addObject:object];
+            }];
+            [self->_memoryCache setObjects:preloadObjects forKeys:preloadKeys];
+        }
+        if (completion) completion(objects.count);
+    });
+}
+
+- (YYCachePrefetchToken *)prefetchObjectsForKeys:(NSArray<NSString *> *)keys {
+    YYCachePrefetchToken *token = [YYCachePrefetchToken new];
+    if (keys.count == 0) return token;
+    __weak typeof(self) _self = self;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        __strong typeof(_self) self = _self;
+        if (!self || token.cancelled) return;
+        // 只预取内存里还没有的key
+        NSMutableArray *missedKeys = [NSMutableArray new];
+        for (NSString *key in keys) {
+            if (![self->_memoryCache containsObjectForKey:key]) [missedKeys addObject:key];
+        }
+        // 分批流水线：每批一次IN查询批量读盘和解档，批与批之间检查取消状态
+        const NSUInteger batchSize = 16;
+        for (NSUInteger i = 0; i < missedKeys.count && !token.cancelled; i += batchSize) {
+            NSRange range = NSMakeRange(i, MIN(batchSize, missedKeys.count - i));
+            NSDictionary *objects = [self->_diskCache objectsForKeys:[missedKeys subarrayWithRange:range]];
+            [objects enumerateKeysAndObjectsUsingBlock:^(NSString *key, id object, BOOL *stop) {
+                // 插入冷端，预取不会把热条目挤出内存缓存
+                [self->_memoryCache setPrefetchedObject:object forKey:key withCost:0];
+            }];
+        }
+    });
+    return token;
+}
+
+- (void)setObjects:(NSArray<id<NSCoding>> *)objects forKeys:(NSArray<NSString *> *)keys {
+    [_memoryCache setObjects:objects forKeys:keys];
+    [_diskCache setObjects:objects forKeys:keys];
+}
+
+- (void)setObjects:(NSArray<id<NSCoding>> *)objects forKeys:(NSArray<NSString *> *)keys withBlock:(void(^)(void))block {
+    [_memoryCache setObjects:objects forKeys:keys];
+    [_diskCache setObjects:objects forKeys:keys withBlock:block];
+}
+
 - (void)setObject:(id<NSCoding>)object forKey:(NSString *)key withBlock:(void (^)(void))block {
     [_memoryCache setObject:object forKey:key];
     [_diskCache setObject:object forKey:key withBlock:block];
@@ -124,6 +280,33 @@
     [_diskCache removeAllObjectsWithBlock:block];
 }
 
+- (void)_recordLatencySince:(NSTimeInterval)begin inHistogram:(atomic_uint_fast64_t *)histogram {
+    NSUInteger bucket = _YYCacheLatencyBucket(CACurrentMediaTime() - begin);
+    atomic_fetch_add_explicit(&histogram[bucket], 1, memory_order_relaxed);
+}
+
+- (YYCacheStatistics)statistics {
+    YYCacheStatistics stats;
+    stats.memory = [_memoryCache statistics];
+    stats.disk = [_diskCache statistics];
+    for (NSUInteger i = 0; i < YYCacheLatencyBucketCount; i++) {
+        stats.memoryHitLatency[i] = atomic_load_explicit(&_memoryHitLatency[i], memory_order_relaxed);
+        stats.diskHitLatency[i] = atomic_load_explicit(&_diskHitLatency[i], memory_order_relaxed);
+        stats.missLatency[i] = atomic_load_explicit(&_missLatency[i], memory_order_relaxed);
+    }
+    return stats;
+}
+
+- (void)resetStatistics {
+    [_memoryCache resetStatistics];
+    [_diskCache resetStatistics];
+    for (NSUInteger i = 0; i < YYCacheLatencyBucketCount; i++) {
+        atomic_store_explicit(&_memoryHitLatency[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&_diskHitLatency[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&_missLatency[i], 0, memory_order_relaxed);
+    }
+}
+
 - (void)removeAllObjectsWithProgressBlock:(void(^)(int removedCount, int totalCount))progress
                                  endBlock:(void(^)(BOOL error))end {
     [_memoryCache removeAllObjects];
@@ -13,18 +13,50 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ Hash used by YYDiskCache to derive a file name from a key when a value is
+ stored as a file and no `customFileNameBlock` is set.
+ 
+ 消息存为文件且未设置 `customFileNameBlock` 时，用key派生文件名的哈希算法
+ */
+typedef NS_ENUM(NSUInteger, YYDiskCacheFilenameHashType) {
+    
+    /// md5(key), 32 hex characters. The historical default.
+    /// md5(key)，32个十六进制字符，历史默认值
+    YYDiskCacheFilenameHashTypeMD5 = 0,
+    
+    /// xxHash64(key), 16 hex characters. Several times faster to compute than
+    /// MD5 on long keys; the hash is only a file name, not a security boundary.
+    /// xxHash64(key)，16个十六进制字符
+    /// 长key时比MD5快数倍；哈希只用作文件名，不承担安全职责
+    YYDiskCacheFilenameHashTypeXXHash64 = 1,
+};
+
+/**
+ A snapshot of the counters maintained by a disk cache. See `statistics`.
+ 磁盘缓存运行计数的快照，见 `statistics`
+ */
+typedef struct YYDiskCacheStatistics {
+    uint64_t hitCount;      ///< Lookups that returned an item. 返回了对象的查询次数
+    uint64_t missCount;     ///< Lookups that returned nothing. 未返回对象的查询次数（过期视作未命中）
+    uint64_t evictionCount; ///< Entries removed by the cost/count/free-space limits. 因限制被淘汰的对象数
+    uint64_t expiredCount;  ///< Entries reclaimed by the expiry sweep. 被过期清扫回收的对象数
+} YYDiskCacheStatistics;
+
 /**
  YYDiskCache is a thread-safe cache that stores key-value pairs backed by SQLite
  and file system (similar to NSURLCache's disk cache).
- 
+
  YYDiskCache has these features:
- 
+
  * It use LRU (least-recently-used) to remove objects.
  * It can be controlled by cost, count, and age.
  * It can be configured to automatically evict objects when there's no free disk space.
  * It can automatically decide the storage type (sqlite/file) for each object to get
       better performance.
- 
+ * Reads run under a shared reader-writer lock, so multiple threads can fetch
+      objects in parallel (sqlite is in WAL mode); only writes are exclusive.
+
  You may compile the latest version of sqlite and ignore the libsqlite3.dylib in
  iOS system to get 2x~4x speed up.
  */
@@ -62,6 +94,59 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly) NSUInteger inlineThreshold;
 
+/**
+ Whether this cache was opened in read-only attach mode.
+ See `readOnlyCacheAtPath:`.
+ 是否以只读附着模式打开，见 `readOnlyCacheAtPath:`
+ */
+@property (nonatomic, readonly, getter=isReadOnly) BOOL readOnly;
+
+/**
+ If `YES`, `inlineThreshold` is refreshed during the background trim pass from
+ the crossover the underlying storage learned by measuring real blob-vs-file
+ read latency (`YYKVStorage.recommendedInlineThreshold`), clamped into
+ [`autoTunedInlineThresholdMin`, `autoTunedInlineThresholdMax`].
+ The default value is NO.
+
+ @discussion The right crossover differs wildly between device generations and
+ between a fresh and a fragmented manifest; the static 20KB default can cost
+ 2x on mid-size reads on some devices. The threshold only affects how new
+ writes are stored, existing items are read back the way they were written.
+
+ 如果是 YES `inlineThreshold` 会在后台清扫时根据底层存储实测的blob/文件读取耗时刷新
+ （见 `YYKVStorage.recommendedInlineThreshold`）
+ 并被夹在 [`autoTunedInlineThresholdMin`, `autoTunedInlineThresholdMax`] 内，默认值是 NO
+ 合适的分界点在不同代的设备、新旧不同的manifest之间差别很大
+ 阈值只影响新写入的存储方式，已有item按写入时的方式读取
+ */
+@property (nonatomic) BOOL autoTunesInlineThreshold;
+
+/**
+ The lower bound for the auto-tuned `inlineThreshold`. Default is 4096 (4KB).
+ 自动调整的 `inlineThreshold` 的下界，默认值是 4096 (4KB)
+ */
+@property (nonatomic) NSUInteger autoTunedInlineThresholdMin;
+
+/**
+ The upper bound for the auto-tuned `inlineThreshold`. Default is 65536 (64KB).
+ 自动调整的 `inlineThreshold` 的上界，默认值是 65536 (64KB)
+ */
+@property (nonatomic) NSUInteger autoTunedInlineThresholdMax;
+
+/**
+ The hash used to derive file names from keys, chosen at init time (read-only).
+ The default value is YYDiskCacheFilenameHashTypeMD5.
+ 
+ @discussion The key-to-filename mapping is stored per item in the manifest,
+ so a cache written with one hash type can be reopened with another: existing
+ items are read back through their stored file names, new items use the new hash.
+ 
+ 用key派生文件名的哈希算法，初始化时选定（只读），默认值是 YYDiskCacheFilenameHashTypeMD5
+ key到文件名的映射按item存储在manifest中，换哈希算法后旧缓存依然可用：
+ 已有item通过存储的文件名读取，新item使用新的哈希
+ */
+@property (readonly) YYDiskCacheFilenameHashType filenameHashType;
+
 /**
  If this block is not nil, then the block will be used to archive object instead
  of NSKeyedArchiver. You can use this block to support the objects which do not
@@ -98,6 +183,51 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nullable, copy) NSString *(^customFileNameBlock)(NSString *key);
 
+/**
+ If `YES`, archived values above `compressionThreshold` are compressed before
+ they are handed to the underlying storage, and decompressed transparently on
+ read. The default value is `NO`.
+
+ @discussion Compression runs after `customArchiveBlock`/NSKeyedArchiver and
+ before the storage type is chosen, so `inlineThreshold` applies to the
+ compressed size. Compressed values carry a small magic header; values written
+ without compression (or before it was enabled) are returned unchanged, so the
+ property can be toggled on an existing cache.
+
+ 如果是 YES 归档后超过 `compressionThreshold` 的value会先压缩再交给底层存储
+ 读取时透明解压，默认值是 NO
+ 压缩在归档之后、选择存储方式之前进行，所以 `inlineThreshold` 按压缩后的大小判断
+ 压缩的value带有小的magic前缀；未压缩写入的旧数据原样返回，可以在已有缓存上开启
+ */
+@property BOOL compressionEnabled;
+
+/**
+ Values smaller than this size (in bytes) are stored uncompressed, they rarely
+ benefit enough to pay the codec cost. The default value is 1024.
+
+ 小于此大小（字节）的value不压缩，压缩收益抵不上编解码开销，默认值是 1024
+ */
+@property NSUInteger compressionThreshold;
+
+/**
+ If this block is not nil, then the block will be used to compress values
+ instead of the built-in LZ4 codec. `customDecompressBlock` must be set to the
+ matching inverse. The default value is nil.
+
+ block不为nil则使用自定义压缩方法替代内建的LZ4，必须同时设置配对的 `customDecompressBlock`
+ 默认值为nil
+ */
+@property (nullable, copy) NSData *(^customCompressBlock)(NSData *data);
+
+/**
+ If this block is not nil, then the block will be used to decompress values
+ written by `customCompressBlock`. The default value is nil.
+
+ block不为nil则用它解压由 `customCompressBlock` 写入的value
+ 默认值为nil
+ */
+@property (nullable, copy) NSData *(^customDecompressBlock)(NSData *data);
+
 
 
 #pragma mark - Limit
@@ -169,9 +299,106 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property NSTimeInterval autoTrimInterval;
 
+/**
+ If `YES`, the periodic trim timer is stopped and trimming is triggered by the
+ set operations instead. The default value is `NO`.
+
+ @discussion With the timer, the cache wakes the CPU every `autoTrimInterval`
+ seconds even when it is completely idle, and a write burst can overshoot the
+ limits for up to a full minute. In event-driven mode the water level is
+ checked every few writes (the check queries sqlite), a background trim is
+ scheduled only when the cache crosses `trimHighWaterRatio` of a limit, and it
+ evicts down to `trimLowWaterRatio` so fluctuations around the limit do not
+ retrigger it. An idle cache costs nothing. Note that in this mode expired and
+ over-age entries are only reclaimed when a trim is triggered by a write.
+
+ 如果是 YES 则停止定时轮询，改为由写入触发清扫，默认值是 NO
+ 定时器即使在缓存完全空闲时也会周期性唤醒CPU，而写入突发则可能超限长达一个周期
+ 事件驱动模式下每隔几次写入检查一次水位（检查需要查询sqlite）
+ 越过高水位（trimHighWaterRatio）才安排一次后台清扫，清到低水位（trimLowWaterRatio）为止
+ 限制附近的小幅波动不会反复触发，空闲时零开销
+ 注意此模式下过期和超龄的对象只在写入触发清扫时回收
+ */
+@property BOOL eventDrivenTrimEnabled;
+
+/**
+ The fraction of a limit that triggers an event-driven trim. Default is 1.0.
+ 触发事件驱动清扫的高水位比例，默认值是 1.0
+ */
+@property double trimHighWaterRatio;
+
+/**
+ The fraction of a limit that an event-driven trim evicts down to. Default is 0.8.
+ 事件驱动清扫的低水位比例，清扫进行到该比例为止，默认值是 0.8
+ */
+@property double trimLowWaterRatio;
+
+/**
+ If `YES`, values stored as files are read back as mmap-backed NSData, so
+ large blobs are paged in on demand and never duplicated in anonymous memory.
+ The default value is `NO`. See `YYKVStorage.mappedReadEnabled` for details.
+
+ 如果是 YES 文件类型的value通过mmap映射读取，大数据按需换页，不在匿名内存中复制
+ 默认值是 NO 详见 `YYKVStorage.mappedReadEnabled`
+ */
+@property BOOL mappedReadEnabled;
+
+/**
+ If `YES`, access-time bookkeeping on cache hits is batched instead of issuing
+ one sqlite UPDATE per read. The default value is `NO`.
+ See `YYKVStorage.defersAccessTimeUpdates` for details.
+
+ 如果是 YES 读命中的访问时间改为批量回写，不再每次读取都执行一条sqlite UPDATE
+ 默认值是 NO 详见 `YYKVStorage.defersAccessTimeUpdates`
+ */
+@property BOOL defersAccessTimeUpdates;
+
+/**
+ If `YES`, batch reads unarchive their items on a bounded concurrent worker
+ pool instead of one at a time on the calling thread. The default value is `NO`.
+
+ @discussion With complex object graphs the NSKeyedUnarchiver decode — not the
+ I/O — dominates multi-get latency. When enabled, `objectsForKeys:` and the
+ warmup reads fan the decode out with dispatch_apply (bounded by the active
+ core count) once a batch has a handful of items; results are merged back in
+ request order. Single-object reads are unaffected.
+
+ @warning When a `customUnarchiveBlock` is set it will be invoked from several
+ threads at once; only enable this if the block is thread-safe.
+
+ 如果是 YES 批量读取的解档摊到有界的并发worker上，而不是在调用线程上逐个进行
+ 默认值是 NO
+ 复杂对象图的多key读取中，耗时大头是NSKeyedUnarchiver解码而不是I/O
+ 开启后 `objectsForKeys:` 和预热读取在批量达到几条时用dispatch_apply摊开解码
+ （worker数量以活跃核心数为界），结果按请求顺序归并，单个读取不受影响
+ @warning 设置了 `customUnarchiveBlock` 时它会被多个线程同时调用
+ 确认block线程安全后再开启
+ */
+@property BOOL concurrentUnarchiveEnabled;
+
+/**
+ If `YES`, small sqlite-bound writes are coalesced into one transaction.
+ The default value is `NO`.
+
+ @discussion Every `setObject:forKey:` normally lands as an individual
+ autocommitted sqlite insert, each paying a WAL sync. With this property set,
+ sets are queued into a small buffer and flushed as one BEGIN/COMMIT
+ transaction, bounded by count, bytes and a few-milliseconds deadline. Reads
+ and removals consult the buffer, so the cache stays consistent; the only
+ change visible to callers is that durability of a write may lag by the flush
+ deadline. File-backed values (above `inlineThreshold`) are not buffered.
+
+ 如果是 YES 小的sqlite写入会合并为一个事务提交，默认值是 NO
+ 普通的 `setObject:forKey:` 每次都是一个独立自动提交的insert，每次提交一次WAL同步
+ 开启后写入先进入小缓冲区，按条数/字节/几毫秒的延迟三个上限触发一次 BEGIN/COMMIT 事务落盘
+ 读取和删除会查询缓冲区，语义保持一致；对调用方唯一可见的变化是写入的持久化最多延迟一个落盘周期
+ 超过 `inlineThreshold` 的文件类型value不会进入缓冲
+ */
+@property BOOL writeCoalescingEnabled;
+
 /**
  Set `YES` to enable error logs for debug.
- 
+
  设置`YES` 容许错误log
  */
 @property BOOL errorLogsEnabled;
@@ -227,7 +454,109 @@ NS_ASSUME_NONNULL_BEGIN
  如果path已经存在内存中，则会直接返回cache对象 取代创建对象
  */
 - (nullable instancetype)initWithPath:(NSString *)path
-                      inlineThreshold:(NSUInteger)threshold NS_DESIGNATED_INITIALIZER;
+                      inlineThreshold:(NSUInteger)threshold;
+
+/**
+ The designated initializer.
+ 
+ @param path       Full path of a directory in which the cache will write data.
+     Once initialized you should not read and write to this directory.
+ 
+ @param threshold  The data store inline threshold in bytes, see
+     `initWithPath:inlineThreshold:` for details.
+ 
+ @param hashType   The hash used to derive file names from keys. Existing caches
+     written with another hash type keep working, see `filenameHashType`.
+ 
+ @return A new cache object, or nil if an error occurs.
+ 
+ @warning If the cache instance for the specified path already exists in memory,
+     this method will return it directly, instead of creating a new instance.
+ 
+ 推荐的实例化方法
+ path cache写入消息的全路径 实例化后，不要在此路径读写数据
+ threshold  存入数据尺寸的限制 详见 `initWithPath:inlineThreshold:`
+ hashType   用key派生文件名的哈希算法 换算法后旧缓存依然可用 详见 `filenameHashType`
+ 返回 cache 对象, 如果发生错误返回nil
+ 如果path已经存在内存中，则会直接返回cache对象 取代创建对象
+ */
+- (nullable instancetype)initWithPath:(NSString *)path
+                      inlineThreshold:(NSUInteger)threshold
+                     filenameHashType:(YYDiskCacheFilenameHashType)hashType;
+
+/**
+ Convenience initializer, equivalent to the designated initializer with
+ readOnly:NO.
+
+ @discussion With `asyncOpen` set, this method returns immediately and the
+ underlying storage (directory creation, sqlite open with schema migration,
+ and corrupt-manifest recovery) is opened on a background queue, so a slow or
+ broken store costs the calling thread — typically app startup — nothing.
+ Operations issued before the store is ready are queued and execute once the
+ open finishes. On open failure the cache stays usable but empty: reads miss
+ and writes are dropped.
+
+ @param path       Full path of a directory in which the cache will write data.
+ @param threshold  The data store inline threshold in bytes, see
+     `initWithPath:inlineThreshold:` for details.
+ @param hashType   The hash used to derive file names from keys.
+ @param asyncOpen  If `YES`, open the underlying storage asynchronously.
+ @param readyBlock A block invoked once the storage finished opening, with
+     whether the open succeeded. Invoked synchronously before this method
+     returns when `asyncOpen` is `NO`. Pass nil to ignore.
+
+ @return A new cache object. With `asyncOpen` an open failure is reported via
+     `readyBlock` instead of returning nil.
+
+ 便利初始化方法，等价于 readOnly 为 NO 的指定初始化方法
+ asyncOpen 为 YES 时此方法立即返回，目录创建、sqlite打开（含schema迁移）
+ 和坏库恢复都在后台队列进行，慢速或损坏的存储不再占用调用方线程（通常是启动线程）
+ 就绪前发起的操作会排队等待打开完成后执行
+ 打开失败时缓存仍然可用但始终为空：读取未命中，写入被丢弃
+ readyBlock 在打开完成后回调，参数为是否成功；asyncOpen 为 NO 时在返回前同步回调
+ */
+- (nullable instancetype)initWithPath:(NSString *)path
+                      inlineThreshold:(NSUInteger)threshold
+                     filenameHashType:(YYDiskCacheFilenameHashType)hashType
+                            asyncOpen:(BOOL)asyncOpen
+                           readyBlock:(nullable void (^)(BOOL success))readyBlock;
+
+/**
+ The designated initializer, adding a read-only attach mode to
+ `initWithPath:inlineThreshold:filenameHashType:asyncOpen:readyBlock:`.
+
+ @param readOnly If `YES`, the cache attaches to a path owned by another
+     process (typically the main app, from a share extension or widget) and
+     never writes: the manifest is opened with SQLITE_OPEN_READONLY, no trim
+     timers or maintenance run, writes and removes are silently ignored, and
+     reads do not refresh access times. A read-only cache does not join the
+     per-path instance dedupe, so it can coexist with a writable instance.
+     Prefer the `readOnlyCacheAtPath:` convenience.
+
+ 指定初始化方法，在 `initWithPath:inlineThreshold:filenameHashType:asyncOpen:readyBlock:`
+ 的基础上增加只读附着模式
+ readOnly 为 YES 时附着到另一个进程（通常是主App）持有的路径，从不写入：
+ manifest以SQLITE_OPEN_READONLY打开，不开清扫定时器、不做维护
+ 写入和删除被静默忽略，读取不刷新访问时间
+ 只读实例不参与同路径去重，可以和一个可写实例共存
+ 一般直接用便利方法 `readOnlyCacheAtPath:`
+ */
+- (nullable instancetype)initWithPath:(NSString *)path
+                      inlineThreshold:(NSUInteger)threshold
+                     filenameHashType:(YYDiskCacheFilenameHashType)hashType
+                            asyncOpen:(BOOL)asyncOpen
+                           readyBlock:(nullable void (^)(BOOL success))readyBlock
+                             readOnly:(BOOL)readOnly NS_DESIGNATED_INITIALIZER;
+
+/**
+ Create a read-only cache attached to an existing cache directory, e.g. from a
+ share extension or widget reading the main app's cache in a shared container.
+ Returns nil if the manifest cannot be opened.
+
+ 以只读模式附着到一个已有的缓存目录，比如Share Extension或Widget读取
+ 主App放在共享容器里的缓存。manifest打不开时返回nil
+ */
++ (nullable instancetype)readOnlyCacheAtPath:(NSString *)path;
 
 
 #pragma mark - Access Methods
@@ -289,19 +618,85 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)objectForKey:(NSString *)key withBlock:(void(^)(NSString *key, id<NSCoding> _Nullable object))block;
 
+/**
+ Returns the values associated with the given keys.
+ This method may blocks the calling thread until file read finished.
+
+ @param keys An array of keys identifying the values. If empty, just return an
+     empty dictionary.
+ @return A dictionary of the keys found in cache and their values. The items
+     are fetched with a single batched sqlite query instead of one query per key.
+
+ 批量获取一组key对应的消息，底层合并为一次sqlite查询，而不是每个key一次
+ keys key的数组，如果为空则返回空字典
+ 返回命中的key和消息对象组成的字典，未命中的key不会出现在结果中
+ */
+- (NSDictionary<NSString *, id<NSCoding>> *)objectsForKeys:(NSArray<NSString *> *)keys;
+
+/**
+ Returns the values associated with the given keys.
+ This method returns immediately and invoke the passed block in background queue
+ when the operation finished.
+
+ @param keys  An array of keys identifying the values.
+ @param block A block which will be invoked in background queue when finished.
+
+ 批量获取一组key对应的消息 此方法会立即返回，并在后台线程中执行，直到执行完成调用block回调
+ keys  key的数组
+ block 在后台线程执行完成后的回调block
+ */
+- (void)objectsForKeys:(NSArray<NSString *> *)keys withBlock:(void(^)(NSDictionary<NSString *, id<NSCoding>> *objects))block;
+
+/**
+ Returns the most recently accessed objects in the cache.
+ This method may blocks the calling thread until file read finished.
+
+ @discussion The manifest keeps a last access time per key, so the hottest
+ entries can be fetched with one ordered query. Intended for warming the
+ memory tier after launch; the access times are not refreshed by this call.
+
+ @param count The maximum number of objects to return.
+ @return A dictionary of the hottest keys and their values.
+
+ 返回缓存中最近访问的对象
+ manifest为每个key维护最后访问时间，一条有序查询即可取出最热的记录
+ 用于启动后预热内存缓存，此调用不会刷新访问时间
+ */
+- (NSDictionary<NSString *, id<NSCoding>> *)objectsOrderByAccessTimeDescWithCount:(NSUInteger)count;
+
 /**
  Sets the value of the specified key in the cache.
  This method may blocks the calling thread until file write finished.
- 
+
  @param object The object to be stored in the cache. If nil, it calls `removeObjectForKey:`.
  @param key    The key with which to associate the value. If nil, this method has no effect.
- 
+
  将消息和对应的key值存入cache中 此方法会堵塞直到写入数据完成
  object 存入cache中的消息对象. 如果是nil则会调用`removeObjectForKey:`.
  key    和消息对象关联的key. 如果为nil则不会操作
  */
 - (void)setObject:(nullable id<NSCoding>)object forKey:(NSString *)key;
 
+/**
+ Sets the value of the specified key in the cache with a time-to-live.
+ This method may blocks the calling thread until file write finished.
+ 
+ @param object The object to be stored in the cache. If nil, it calls `removeObjectForKey:`.
+ @param key    The key with which to associate the value. If nil, this method has no effect.
+ @param ttl    Seconds until the entry expires. 0 or a negative value means no expiry.
+ @discussion Expiration is lazy: an expired entry is treated as a miss on read
+ and its storage is reclaimed by the periodic trim pass. Setting the key again
+ resets (or clears) its ttl.
+ 
+ 根据指定的key和存活时间ttl存入消息，此方法会堵塞线程 直到文件写入完毕
+ object 需要存入的消息 如果是nil 则调用 `removeObjectForKey:`.
+ key 消息的key 如果是nil 则不执行操作
+ ttl 过期秒数，0或负值表示不过期
+ 过期采用惰性回收：读取时过期的消息当作未命中，存储由周期清扫回收
+ 再次写入同一key会重置（或清除）ttl
+ */
+- (void)setObject:(nullable id<NSCoding>)object forKey:(NSString *)key withTTL:(NSTimeInterval)ttl;
+
 /**
  Sets the value of the specified key in the cache.
  This method returns immediately and invoke the passed block in background queue
@@ -317,12 +712,115 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)setObject:(nullable id<NSCoding>)object forKey:(NSString *)key withBlock:(void(^)(void))block;
 
+/**
+ Stores the contents of an existing file as the value of the specified key,
+ without loading it into memory.
+
+ @discussion The source file is hard-linked into the cache's data directory
+ when it is on the same volume, and copied by the file system otherwise, so
+ caching a large payload (a downloaded video segment for example) never
+ doubles its memory footprint. The value is stored as the file's raw bytes —
+ it is not archived or compressed — so read it back with `fileURLForKey:`,
+ or with `objectForKey:` only when a `customUnarchiveBlock` is set that
+ accepts raw data. The cache `type` should not be YYKVStorageTypeSQLite.
+
+ @param fileURL A file URL of the source file. If nil, it calls `removeObjectForKey:`.
+ @param key     The key with which to associate the value. If nil, this method has no effect.
+
+ 把一个已存在文件的内容作为value存入cache，全程不载入内存
+ 源文件在同一卷时硬链接进data目录，跨卷时由文件系统复制
+ 缓存大payload（比如下载下来的视频分片）时内存占用不会翻倍
+ value按文件原始字节存储，不经过归档和压缩——
+ 读取用 `fileURLForKey:`，或在设置了能接受原始数据的 `customUnarchiveBlock` 时用 `objectForKey:`
+ cache的存储类型不能是 YYKVStorageTypeSQLite
+ fileURL 源文件的文件URL. 如果是nil则会调用`removeObjectForKey:`.
+ key     和value关联的key. 如果为nil则不会操作
+ */
+- (void)setFileURL:(nullable NSURL *)fileURL forKey:(NSString *)key;
+
+/**
+ Stores the contents of an existing file as the value of the specified key,
+ with a time-to-live.
+
+ @discussion Same as `setFileURL:forKey:`, with an expiration after `ttl`
+ seconds.
+
+ @param fileURL A file URL of the source file. If nil, it calls `removeObjectForKey:`.
+ @param key     The key with which to associate the value. If nil, this method has no effect.
+ @param ttl     The time-to-live in seconds. Zero or negative means never expires.
+
+ 把一个已存在文件的内容作为带过期时间的value存入cache
+ 和 `setFileURL:forKey:` 一致，`ttl` 秒后过期
+ ttl 过期秒数，0或负值表示不过期
+ */
+- (void)setFileURL:(nullable NSURL *)fileURL forKey:(NSString *)key withTTL:(NSTimeInterval)ttl;
+
+/**
+ Returns a file URL for the value of the specified key, if it is stored as a
+ file.
+
+ @discussion The returned URL points at the file inside the cache's data
+ directory, so a large value can be handed to readers (e.g. AVPlayer,
+ NSFileHandle) without loading it into memory. Returns nil for values stored
+ inline in sqlite or in the slab file.
+
+ @warning The file belongs to the cache: it may disappear once the key is
+ removed or trimmed. Hard-link it or finish reading before releasing control.
+
+ @param key A specified key.
+ @return A file URL for the value, or nil if not exists / not stored as a file.
+
+ 根据key获取value的文件URL（仅当value以文件形式存储时）
+ 返回的URL指向cache的data目录内的文件，大value可以直接交给读取方
+ （如 AVPlayer、NSFileHandle）而不经过内存
+ value内联在sqlite或slab中时返回nil
+ @warning 文件归cache所有：key被删除或清理后文件随时可能消失
+ 需要长期持有就先硬链接出去，或在失去控制前读完
+ key  特定的key值
+ 返回value的文件URL，不存在或非文件存储返回nil
+ */
+- (nullable NSURL *)fileURLForKey:(NSString *)key;
+
+/**
+ Sets the values of the specified keys in the cache.
+ This method may blocks the calling thread until file write finished.
+
+ @param objects An array of objects to be stored in the cache.
+ @param keys    An array of keys, must have the same count as `objects`.
+
+ @discussion The objects are archived outside the lock, then written in one
+ locked pass, so a batch of sets is much cheaper than calling
+ `setObject:forKey:` in a loop.
+
+ 批量将一组键值对存入cache中 此方法会堵塞直到写入数据完成
+ objects 存入cache中的消息对象数组
+ keys    关联的key数组，数量必须和 `objects` 一致
+ 归档在锁外完成，写入只加一次锁，比循环调用 `setObject:forKey:` 开销低很多
+ */
+- (void)setObjects:(NSArray<id<NSCoding>> *)objects forKeys:(NSArray<NSString *> *)keys;
+
+/**
+ Sets the values of the specified keys in the cache.
+ This method returns immediately and invoke the passed block in background queue
+ when the operation finished.
+
+ @param objects An array of objects to be stored in the cache.
+ @param keys    An array of keys, must have the same count as `objects`.
+ @param block   A block which will be invoked in background queue when finished.
+
+ 批量将一组键值对存入cache中 此方法会立即返回，并在后台线程中执行，直到执行完成调用block回调
+ objects 存入cache中的消息对象数组
+ keys    关联的key数组，数量必须和 `objects` 一致
+ block   在后台执行完后的回调block
+ */
+- (void)setObjects:(NSArray<id<NSCoding>> *)objects forKeys:(NSArray<NSString *> *)keys withBlock:(void(^)(void))block;
+
 /**
  Removes the value of the specified key in the cache.
  This method may blocks the calling thread until file delete finished.
- 
+
  @param key The key identifying the value to be removed. If nil, this method has no effect.
- 
+
  删除cache中指定key对应的消息 此方法会堵塞直到文件删除完成
  key 标识删除对象的key 如果为nil则不会操作
  */
@@ -506,6 +1004,33 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)trimToAge:(NSTimeInterval)age withBlock:(void(^)(void))block;
 
+#pragma mark - Statistics
+///=============================================================================
+/// @name Statistics
+///=============================================================================
+
+/**
+ Returns a snapshot of the hit/miss/eviction/expiry counters.
+
+ @discussion The hit/miss counters are maintained with relaxed atomic
+ increments on the access paths; eviction and expiry counts are derived from
+ the item count around the trim passes. Cheap enough to leave enabled in
+ production. Counts cover `objectForKey:` and `objectsForKeys:`; explicit
+ removals are not counted as evictions.
+
+ 返回命中/未命中/淘汰/过期计数的快照
+ 命中计数在访问路径上用relaxed原子自增维护，淘汰和过期计数在清扫前后按条数差计算
+ 开销可以忽略，适合在线上常开
+ 只统计 `objectForKey:` 和 `objectsForKeys:`，显式删除不计入淘汰
+ */
+- (YYDiskCacheStatistics)statistics;
+
+/**
+ Resets all statistics counters to zero.
+ 将所有统计计数清零
+ */
+- (void)resetStatistics;
+
 
 #pragma mark - Extended Data
 ///=============================================================================
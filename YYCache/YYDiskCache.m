@@ -15,23 +15,54 @@
 #import <CommonCrypto/CommonCrypto.h>
 #import <objc/runtime.h>
 #import <time.h>
+#import <pthread.h>
+#import <stdatomic.h>
+#if __has_include(<compression.h>)
+#import <compression.h>
+#define YYDiskCacheHasCompression 1
+#endif
 
 
 /**
- 线程信号（锁）
+ 写锁，写入、删除和清理互斥
  */
-#define Lock() dispatch_semaphore_wait(self->_lock, DISPATCH_TIME_FOREVER)
+#define Lock() do { [self _waitUntilOpened]; pthread_rwlock_wrlock(&self->_lock); } while (0)
 
 /**
- 线程信号（解锁）
+ 写锁（解锁）
  */
-#define Unlock() dispatch_semaphore_signal(self->_lock)
+#define Unlock() pthread_rwlock_unlock(&self->_lock)
+
+/**
+ 读锁，多个读取可以并行，只和写入互斥
+ */
+#define ReadLock() do { [self _waitUntilOpened]; pthread_rwlock_rdlock(&self->_lock); } while (0)
+
+/**
+ 读锁（解锁）
+ */
+#define ReadUnlock() pthread_rwlock_unlock(&self->_lock)
 
 /**
  存取拓展数据的key
  */
 static const int extended_data_key;
 
+static const NSUInteger kWriteCoalescingMaxCount = 32;              /// 合并写入缓冲的最大条数
+static const NSUInteger kWriteCoalescingMaxBytes = 2 * 1024 * 1024; /// 合并写入缓冲的最大字节数
+static const NSTimeInterval kWriteCoalescingDelay = 0.01;           /// 合并写入的最长延迟（秒）
+
+static const NSUInteger kEventTrimCheckInterval = 16;   /// 事件驱动模式下每多少次写入检查一次水位（检查需要查询sqlite）
+
+static const NSUInteger kConcurrentUnarchiveMinCount = 4;   /// 并行解档的最少item数量，小批量派发worker得不偿失
+
+static const NSTimeInterval kAccessTimeFlushDelay = 5.0;    /// 访问时间延迟批量回写的秒数
+
+static const uint8_t kCompressionMagic[4] = {'Y', 'Y', 'C', 'Z'};   /// 压缩value的magic前缀
+static const uint8_t kCompressionCodecLZ4 = 1;                      /// 默认LZ4编解码器
+static const uint8_t kCompressionCodecCustom = 2;                   /// 自定义block编解码器
+static const NSUInteger kCompressionHeaderLength = 9;               /// magic(4) + codec(1) + 原始长度(4)
+
 /// Free disk space in bytes.
 /// 获取disk的空闲容量
 static int64_t _YYDiskSpaceFree() {
@@ -59,6 +90,75 @@ static NSString *_YYNSStringMD5(NSString *string) {
             ];
 }
 
+/// String's xxHash64 hash, as 16 hex characters.
+/// 获取字符串xxHash64值（16个十六进制字符）
+static NSString *_YYNSStringXXHash64(NSString *string) {
+    if (!string) return nil;
+    static const uint64_t prime1 = 11400714785074694791UL;
+    static const uint64_t prime2 = 14029467366897019727UL;
+    static const uint64_t prime3 = 1609587929392839161UL;
+    static const uint64_t prime4 = 9650029242287828579UL;
+    static const uint64_t prime5 = 2870177450012600261UL;
+    
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    const uint8_t *p = data.bytes;
+    const uint8_t *end = p + data.length;
+    uint64_t hash;
+    
+    if (data.length >= 32) {
+        const uint8_t *limit = end - 32;
+        uint64_t v1 = prime1 + prime2;
+        uint64_t v2 = prime2;
+        uint64_t v3 = 0;
+        uint64_t v4 = (uint64_t)0 - prime1;
+        do {
+            uint64_t lane;
+#define XXRound(acc) \
+            memcpy(&lane, p, 8); p += 8; \
+            (acc) += lane * prime2; \
+            (acc) = ((acc) << 31) | ((acc) >> 33); \
+            (acc) *= prime1;
+            XXRound(v1); XXRound(v2); XXRound(v3); XXRound(v4);
+        } while (p <= limit);
+        hash = ((v1 << 1) | (v1 >> 63)) + ((v2 << 7) | (v2 >> 57))
+             + ((v3 << 12) | (v3 >> 52)) + ((v4 << 18) | (v4 >> 46));
+#define XXMerge(acc, val) \
+        (val) *= prime2; (val) = ((val) << 31) | ((val) >> 33); (val) *= prime1; \
+        (acc) ^= (val); (acc) = (acc) * prime1 + prime4;
+        XXMerge(hash, v1); XXMerge(hash, v2); XXMerge(hash, v3); XXMerge(hash, v4);
+#undef XXRound
+#undef XXMerge
+    } else {
+        hash = prime5;
+    }
+    hash += (uint64_t)data.length;
+    
+    while (p + 8 <= end) {
+        uint64_t lane;
+        memcpy(&lane, p, 8); p += 8;
+        lane *= prime2; lane = (lane << 31) | (lane >> 33); lane *= prime1;
+        hash ^= lane;
+        hash = ((hash << 27) | (hash >> 37)) * prime1 + prime4;
+    }
+    if (p + 4 <= end) {
+        uint32_t lane;
+        memcpy(&lane, p, 4); p += 4;
+        hash ^= (uint64_t)lane * prime1;
+        hash = ((hash << 23) | (hash >> 41)) * prime2 + prime3;
+    }
+    while (p < end) {
+        hash ^= (uint64_t)(*p++) * prime5;
+        hash = ((hash << 11) | (hash >> 53)) * prime1;
+    }
+    
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return [NSString stringWithFormat:@"%016llx", (unsigned long long)hash];
+}
+
 /// weak reference for all instances
 /**
  Map表保存cache实例
@@ -110,8 +210,35 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
 
 @implementation YYDiskCache {
     YYKVStorage *_kv;
-    dispatch_semaphore_t _lock;
+    pthread_rwlock_t _lock;
     dispatch_queue_t _queue;
+
+    NSMutableDictionary<NSString *, YYKVStorageItem *> *_pendingWrites; /// 合并写入的缓冲，由 _lock 保护
+    NSUInteger _pendingWriteBytes;  /// 缓冲中value的总字节数
+    BOOL _flushScheduled;           /// 是否已经安排了延迟落盘
+
+    NSUInteger _writesSinceTrimCheck;   /// 距离上次水位检查的写入次数，由 _lock 保护
+    BOOL _trimScheduled;                /// 事件驱动模式下是否已经安排了一次后台清扫，由 _lock 保护
+
+    dispatch_group_t _openGroup;        /// 异步打开时的就绪信号
+    atomic_bool _openPending;           /// 底层存储是否还在后台打开中（release写/acquire读，保证看到NO时_kv已发布）
+
+    atomic_uint_fast64_t _hitCount;         /// 命中次数（relaxed原子计数，常开无感知开销）
+    atomic_uint_fast64_t _missCount;        /// 未命中次数
+    atomic_uint_fast64_t _evictionCount;    /// 因cost/count/空间限制被淘汰的对象数
+    atomic_uint_fast64_t _expiredCount;     /// 因TTL过期被回收的对象数
+
+    atomic_bool _accessTimeFlushScheduled;  /// 是否已经安排了延迟的访问时间批量回写（读路径上设置，故用原子量）
+}
+
+/**
+ 异步打开模式下等待底层存储就绪，打开完成后只剩一次分支判断的开销
+ 所有加锁宏都会先经过这里，未就绪时的操作排队等待而不是失败
+ */
+- (void)_waitUntilOpened {
+    if (atomic_load_explicit(&_openPending, memory_order_acquire)) {
+        dispatch_group_wait(_openGroup, DISPATCH_TIME_FOREVER);
+    }
 }
 
 /**
@@ -122,36 +249,124 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
     dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_autoTrimInterval * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
         __strong typeof(_self) self = _self;
         if (!self) return;
+        if (self->_eventDrivenTrimEnabled) return; // 事件驱动模式下停止轮询，空闲时不再唤醒CPU
         [self _trimInBackground];
         // 定时清除递归调用
         [self _trimRecursively];
     });
 }
 
+/**
+ 事件驱动清扫：写入越过高水位时才安排一次后台清扫，清到低水位为止
+ 水位检查需要查询sqlite，所以每 kEventTrimCheckInterval 次写入才检查一次
+ 调用方必须已经持有写锁
+ */
+- (void)_scheduleTrimIfNeededLocked {
+    if (!_eventDrivenTrimEnabled || _trimScheduled) return;
+    if (++_writesSinceTrimCheck < kEventTrimCheckInterval) return;
+    _writesSinceTrimCheck = 0;
+    BOOL overHighWater = NO;
+    if (_costLimit != NSUIntegerMax && _costLimit < INT_MAX) {
+        overHighWater = [_kv getItemsSize] > (int)(_costLimit * _trimHighWaterRatio);
+    }
+    if (!overHighWater && _countLimit != NSUIntegerMax && _countLimit < INT_MAX) {
+        overHighWater = [_kv getItemsCount] > (int)(_countLimit * _trimHighWaterRatio);
+    }
+    if (!overHighWater) return;
+    _trimScheduled = YES;
+    __weak typeof(self) _self = self;
+    dispatch_async(_queue, ^{
+        __strong typeof(_self) self = _self;
+        if (!self) return;
+        Lock();
+        [self _trimExpired];
+        if (self->_costLimit != NSUIntegerMax && self->_costLimit < INT_MAX) {
+            [self _trimToCost:(NSUInteger)(self->_costLimit * self->_trimLowWaterRatio)];
+        }
+        if (self->_countLimit != NSUIntegerMax && self->_countLimit < INT_MAX) {
+            [self _trimToCount:(NSUInteger)(self->_countLimit * self->_trimLowWaterRatio)];
+        }
+        // 高低水位只针对cost/count，超龄和磁盘剩余空间直接清到各自的限制
+        [self _trimToAge:self->_ageLimit];
+        [self _trimToFreeDiskSpace:self->_freeDiskSpaceLimit];
+        self->_trimScheduled = NO;
+        Unlock();
+    });
+}
+
+/**
+ 读命中后挂一个延迟的访问时间批量回写
+ 回写是一次sqlite写入，必须和其它写入互斥，所以延迟block拿着写锁执行
+ （读路径上只有一次原子标志位的开销，不加锁）
+ */
+- (void)_scheduleAccessTimeFlushIfNeeded {
+    if (!_kv.defersAccessTimeUpdates) return;
+    bool expected = false;
+    if (!atomic_compare_exchange_strong(&_accessTimeFlushScheduled, &expected, true)) return;
+    __weak typeof(self) _self = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kAccessTimeFlushDelay * NSEC_PER_SEC)), _queue, ^{
+        __strong typeof(_self) self = _self;
+        if (!self) return;
+        Lock();
+        atomic_store(&self->_accessTimeFlushScheduled, false);
+        [self->_kv flushAccessTimeUpdates];
+        Unlock();
+    });
+}
+
 /**
  后台清除LRU对象
  */
+/**
+ 根据底层存储实测学习到的分界尺寸刷新inlineThreshold，夹在配置的上下界内
+ 还没学到结论时保持现值不变，调用方必须已经持有锁
+ */
+- (void)_autoTuneInlineThreshold {
+    NSUInteger recommended = _kv.recommendedInlineThreshold;
+    if (recommended == 0) return;
+    if (recommended < _autoTunedInlineThresholdMin) recommended = _autoTunedInlineThresholdMin;
+    if (recommended > _autoTunedInlineThresholdMax) recommended = _autoTunedInlineThresholdMax;
+    _inlineThreshold = recommended;
+}
+
 - (void)_trimInBackground {
     __weak typeof(self) _self = self;
     dispatch_async(_queue, ^{
         __strong typeof(_self) self = _self;
         if (!self) return;
         Lock();
+        [self _trimExpired];
         [self _trimToCost:self.costLimit];
         [self _trimToCount:self.countLimit];
         [self _trimToAge:self.ageLimit];
         [self _trimToFreeDiskSpace:self.freeDiskSpaceLimit];
+        // 清扫是后台的空闲时机，顺便做一次按需的sqlite维护
+        [self->_kv performMaintenanceIfNeeded];
+        if (self->_autoTunesInlineThreshold) [self _autoTuneInlineThreshold];
         Unlock();
     });
 }
 
+/**
+ 清除已过期的对象（惰性回收）
+ */
+- (void)_trimExpired {
+    // 清扫方法不返回删除数量，用前后的条数差维护统计计数
+    int before = [_kv getItemsCount];
+    [_kv removeExpiredItems];
+    int removed = before - [_kv getItemsCount];
+    if (removed > 0) atomic_fetch_add_explicit(&_expiredCount, removed, memory_order_relaxed);
+}
+
 /**
  按照总开销清除LRU对象
  */
 - (void)_trimToCost:(NSUInteger)costLimit {
     if (costLimit >= INT_MAX) return;
+    int before = [_kv getItemsCount];
     [_kv removeItemsToFitSize:(int)costLimit];
-    
+    int removed = before - [_kv getItemsCount];
+    if (removed > 0) atomic_fetch_add_explicit(&_evictionCount, removed, memory_order_relaxed);
 }
 
 /**
@@ -159,7 +374,10 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
  */
 - (void)_trimToCount:(NSUInteger)countLimit {
     if (countLimit >= INT_MAX) return;
+    int before = [_kv getItemsCount];
     [_kv removeItemsToFitCount:(int)countLimit];
+    int removed = before - [_kv getItemsCount];
+    if (removed > 0) atomic_fetch_add_explicit(&_evictionCount, removed, memory_order_relaxed);
 }
 
 /**
@@ -193,13 +411,36 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
     [self _trimToCost:(int)costLimit];
 }
 
+/**
+ Flush the coalesced write buffer as one transaction, the lock must be held.
+ 将合并写入缓冲作为一个事务落盘，调用方必须已经持有锁
+ */
+- (void)_flushPendingWritesLocked {
+    if (_pendingWrites.count == 0) return;
+    NSArray *items = _pendingWrites.allValues;
+    [_pendingWrites removeAllObjects];
+    _pendingWriteBytes = 0;
+    [_kv saveItems:items];
+    [self _scheduleTrimIfNeededLocked];
+}
+
 /**
  通过key获取文件名
  */
 - (NSString *)_filenameForKey:(NSString *)key {
     NSString *filename = nil;
     if (_customFileNameBlock) filename = _customFileNameBlock(key);
-    if (!filename) filename = _YYNSStringMD5(key);
+    if (!filename) {
+        switch (_filenameHashType) {
+            case YYDiskCacheFilenameHashTypeXXHash64: {
+                filename = _YYNSStringXXHash64(key);
+            } break;
+            case YYDiskCacheFilenameHashTypeMD5:
+            default: {
+                filename = _YYNSStringMD5(key);
+            } break;
+        }
+    }
     return filename;
 }
 
@@ -209,6 +450,11 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
  */
 - (void)_appWillBeTerminated {
     Lock();
+    [self _flushPendingWritesLocked];
+    // 终止前把积攒的访问时间落库，LRU顺序才能保留到下次启动
+    [_kv flushAccessTimeUpdates];
+    // 终止前按需维护一次：只在wal明显过大（或删除积压）时才合并回主库，普通退出不多花时间
+    [_kv performMaintenanceIfNeeded];
     _kv = nil;
     Unlock();
 }
@@ -217,6 +463,7 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
 
 - (void)dealloc {
     [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationWillTerminateNotification object:nil];
+    pthread_rwlock_destroy(&_lock);
 }
 
 - (instancetype)init {
@@ -233,11 +480,39 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
 
 - (instancetype)initWithPath:(NSString *)path
              inlineThreshold:(NSUInteger)threshold {
+    return [self initWithPath:path inlineThreshold:threshold filenameHashType:YYDiskCacheFilenameHashTypeMD5];
+}
+
+- (instancetype)initWithPath:(NSString *)path
+             inlineThreshold:(NSUInteger)threshold
+            filenameHashType:(YYDiskCacheFilenameHashType)hashType {
+    return [self initWithPath:path inlineThreshold:threshold filenameHashType:hashType asyncOpen:NO readyBlock:nil];
+}
+
+- (instancetype)initWithPath:(NSString *)path
+             inlineThreshold:(NSUInteger)threshold
+            filenameHashType:(YYDiskCacheFilenameHashType)hashType
+                   asyncOpen:(BOOL)asyncOpen
+                  readyBlock:(void (^)(BOOL success))readyBlock {
+    return [self initWithPath:path inlineThreshold:threshold filenameHashType:hashType asyncOpen:asyncOpen readyBlock:readyBlock readOnly:NO];
+}
+
+- (instancetype)initWithPath:(NSString *)path
+             inlineThreshold:(NSUInteger)threshold
+            filenameHashType:(YYDiskCacheFilenameHashType)hashType
+                   asyncOpen:(BOOL)asyncOpen
+                  readyBlock:(void (^)(BOOL success))readyBlock
+                    readOnly:(BOOL)readOnly {
     self = [super init];
     if (!self) return nil;
-    
-    YYDiskCache *globalCache = _YYDiskCacheGetGlobal(path);
-    if (globalCache) return globalCache;
+    pthread_rwlock_init(&_lock, NULL);
+    _readOnly = readOnly;
+
+    if (!readOnly) {
+        // 只读实例不参与同路径去重，可以和一个可写实例共存
+        YYDiskCache *globalCache = _YYDiskCacheGetGlobal(path);
+        if (globalCache) return globalCache;
+    }
     
     YYKVStorageType type;
     if (threshold == 0) {
@@ -248,20 +523,50 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
         type = YYKVStorageTypeMixed;
     }
     
-    YYKVStorage *kv = [[YYKVStorage alloc] initWithPath:path type:type];
-    if (!kv) return nil;
-    
-    _kv = kv;
+    if (asyncOpen) {
+        // 目录创建、sqlite打开和坏库恢复都在后台进行，调用方线程立即返回
+        // 就绪前的操作通过加锁宏排队等待，而不是失败
+        _openGroup = dispatch_group_create();
+        atomic_store(&_openPending, true);
+        dispatch_group_enter(_openGroup);
+        dispatch_group_t openGroup = _openGroup;
+        __weak typeof(self) _self = self;
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            YYKVStorage *kv = [[YYKVStorage alloc] initWithPath:path type:type readOnly:readOnly];
+            __strong typeof(_self) self = _self;
+            if (self) {
+                self->_kv = kv;
+                // release保证其他线程看到NO之前_kv已经可见
+                atomic_store_explicit(&self->_openPending, false, memory_order_release);
+            }
+            dispatch_group_leave(openGroup);
+            if (readyBlock) readyBlock(kv != nil);
+        });
+    } else {
+        YYKVStorage *kv = [[YYKVStorage alloc] initWithPath:path type:type readOnly:readOnly];
+        if (!kv) return nil;
+        _kv = kv;
+        if (readyBlock) readyBlock(YES);
+    }
     _path = path;
-    _lock = dispatch_semaphore_create(1);
     _queue = dispatch_queue_create("com.ibireme.cache.disk", DISPATCH_QUEUE_CONCURRENT);
     _inlineThreshold = threshold;
+    _filenameHashType = hashType;
+    _compressionThreshold = 1024;
     _countLimit = NSUIntegerMax;
     _costLimit = NSUIntegerMax;
     _ageLimit = DBL_MAX;
     _freeDiskSpaceLimit = 0;
     _autoTrimInterval = 60;
+    _trimHighWaterRatio = 1.0;
+    _trimLowWaterRatio = 0.8;
+    _autoTunedInlineThresholdMin = 4 * 1024;
+    _autoTunedInlineThresholdMax = 64 * 1024;
     
+    if (readOnly) {
+        // 只读附着：不清扫、不维护，也没有要在终止时落盘的东西
+        return self;
+    }
     // 开启递归定时清扫
     [self _trimRecursively];
     // 设置 YYDiskCache
@@ -271,11 +576,22 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
     return self;
 }
 
++ (instancetype)readOnlyCacheAtPath:(NSString *)path {
+    if (path.length == 0) return nil;
+    YYDiskCache *cache = [[self alloc] initWithPath:path
+                                    inlineThreshold:1024 * 20
+                                   filenameHashType:YYDiskCacheFilenameHashTypeMD5
+                                          asyncOpen:NO
+                                         readyBlock:nil
+                                           readOnly:YES];
+    return cache;
+}
+
 - (BOOL)containsObjectForKey:(NSString *)key {
     if (!key) return NO;
-    Lock();
-    BOOL contains = [_kv itemExistsForKey:key];
-    Unlock();
+    ReadLock();
+    BOOL contains = (_pendingWrites[key] != nil) || [_kv itemExistsForKey:key];
+    ReadUnlock();
     return contains;
 }
 
@@ -289,19 +605,19 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
     });
 }
 
-- (id<NSCoding>)objectForKey:(NSString *)key {
-    if (!key) return nil;
-    Lock();
-    YYKVStorageItem *item = [_kv getItemForKey:key];
-    Unlock();
+/**
+ 根据item的value解档出消息对象，并绑定拓展数据
+ */
+- (id<NSCoding>)_objectFromItem:(YYKVStorageItem *)item {
     if (!item.value) return nil;
-    
+    NSData *value = [self _decompressedDataFromData:item.value];
+    if (!value) return nil;
     id object = nil;
     if (_customUnarchiveBlock) {
-        object = _customUnarchiveBlock(item.value);
+        object = _customUnarchiveBlock(value);
     } else {
         @try {
-            object = [NSKeyedUnarchiver unarchiveObjectWithData:item.value];
+            object = [NSKeyedUnarchiver unarchiveObjectWithData:value];
         }
         @catch (NSException *exception) {
             // nothing to do...
@@ -314,6 +630,170 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
     return object;
 }
 
+/**
+ 批量解档一组items为key->消息对象的字典
+ 开启并行解档且数量够多时把解档摊到并发worker上，否则在调用线程上逐个解档
+ */
+- (NSDictionary *)_objectsFromItems:(NSArray<YYKVStorageItem *> *)items {
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:items.count];
+    NSUInteger count = items.count;
+    id __strong *objects = NULL;
+    if (_concurrentUnarchiveEnabled && count >= kConcurrentUnarchiveMinCount) {
+        objects = (id __strong *)calloc(count, sizeof(id));
+    }
+    if (objects) {
+        // 解档结果先落进和items等长的临时数组，归并时顺序和请求一致
+        // dispatch_apply按活跃核心数限定worker数量，不会无限fan-out
+        dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+            YYKVStorageItem *item = items[i];
+            if (item.key) objects[i] = [self _objectFromItem:item];
+        });
+        for (NSUInteger i = 0; i < count; i++) {
+            if (objects[i]) result[items[i].key] = objects[i];
+            objects[i] = nil;
+        }
+        free(objects);
+    } else {
+        for (YYKVStorageItem *item in items) {
+            if (!item.key) continue;
+            id object = [self _objectFromItem:item];
+            if (object) result[item.key] = object;
+        }
+    }
+    return result;
+}
+
+/**
+ 归档消息对象为data数据
+ */
+- (NSData *)_dataFromObject:(id<NSCoding>)object {
+    NSData *value = nil;
+    if (_customArchiveBlock) {
+        value = _customArchiveBlock(object);
+    } else {
+        @try {
+            value = [NSKeyedArchiver archivedDataWithRootObject:object];
+        }
+        @catch (NSException *exception) {
+            // nothing to do...
+        }
+    }
+    return value;
+}
+
+/**
+ 压缩归档后的value，带上magic前缀以便读取时透明解压
+ 没有收益（压缩后更大）或未达阈值时返回原数据
+ */
+- (NSData *)_compressedDataFromData:(NSData *)value {
+    if (!_compressionEnabled || value.length < _compressionThreshold) return value;
+    
+    uint8_t codec;
+    NSData *compressed = nil;
+    if (_customCompressBlock) {
+        codec = kCompressionCodecCustom;
+        compressed = _customCompressBlock(value);
+    } else {
+#ifdef YYDiskCacheHasCompression
+        codec = kCompressionCodecLZ4;
+        NSMutableData *buffer = [NSMutableData dataWithLength:value.length];
+        size_t length = compression_encode_buffer(buffer.mutableBytes, value.length,
+                                                  value.bytes, value.length,
+                                                  NULL, COMPRESSION_LZ4);
+        if (length > 0) {
+            buffer.length = length;
+            compressed = buffer;
+        }
+#else
+        return value;
+#endif
+    }
+    if (!compressed || compressed.length + kCompressionHeaderLength >= value.length) return value;
+    
+    NSMutableData *result = [NSMutableData dataWithCapacity:compressed.length + kCompressionHeaderLength];
+    [result appendBytes:kCompressionMagic length:4];
+    [result appendBytes:&codec length:1];
+    uint32_t rawLength = (uint32_t)value.length;
+    [result appendBytes:&rawLength length:4];
+    [result appendData:compressed];
+    return result;
+}
+
+/**
+ 根据magic前缀透明解压value，没有前缀的旧数据原样返回
+ */
+- (NSData *)_decompressedDataFromData:(NSData *)value {
+    if (value.length < kCompressionHeaderLength) return value;
+    const uint8_t *bytes = value.bytes;
+    if (memcmp(bytes, kCompressionMagic, 4) != 0) return value;
+    
+    uint8_t codec = bytes[4];
+    uint32_t rawLength;
+    memcpy(&rawLength, bytes + 5, 4);
+    NSData *compressed = [value subdataWithRange:NSMakeRange(kCompressionHeaderLength, value.length - kCompressionHeaderLength)];
+    if (codec == kCompressionCodecCustom) {
+        return _customDecompressBlock ? _customDecompressBlock(compressed) : nil;
+    }
+#ifdef YYDiskCacheHasCompression
+    if (codec == kCompressionCodecLZ4) {
+        NSMutableData *buffer = [NSMutableData dataWithLength:rawLength];
+        size_t length = compression_decode_buffer(buffer.mutableBytes, rawLength,
+                                                  compressed.bytes, compressed.length,
+                                                  NULL, COMPRESSION_LZ4);
+        if (length != rawLength) return nil;
+        return buffer;
+    }
+#endif
+    return nil;
+}
+
+- (id<NSCoding>)objectForKey:(NSString *)key {
+    if (!key) return nil;
+    ReadLock();
+    YYKVStorageItem *item = _pendingWrites[key];
+    if (!item) item = [_kv getItemForKey:key];
+    ReadUnlock();
+    atomic_fetch_add_explicit(item ? &_hitCount : &_missCount, 1, memory_order_relaxed);
+    if (item) [self _scheduleAccessTimeFlushIfNeeded];
+    return [self _objectFromItem:item];
+}
+
+- (NSDictionary<NSString *, id<NSCoding>> *)objectsForKeys:(NSArray<NSString *> *)keys {
+    if (keys.count == 0) return [NSDictionary dictionary];
+    ReadLock();
+    NSMutableArray *items = [NSMutableArray new];
+    NSArray *queryKeys = keys;
+    if (_pendingWrites.count) {
+        NSMutableArray *missedKeys = [NSMutableArray new];
+        for (NSString *key in keys) {
+            YYKVStorageItem *item = _pendingWrites[key];
+            if (item) [items addObject:item];
+            else [missedKeys addObject:key];
+        }
+        queryKeys = missedKeys;
+    }
+    if (queryKeys.count) {
+        NSArray *dbItems = [_kv getItemForKeys:queryKeys];
+        if (dbItems) [items addObjectsFromArray:dbItems];
+    }
+    ReadUnlock();
+    atomic_fetch_add_explicit(&_hitCount, items.count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_missCount, keys.count - items.count, memory_order_relaxed);
+    if (items.count) [self _scheduleAccessTimeFlushIfNeeded];
+    // 解档在锁外进行，复杂对象图的批量解档可以摊到多个核心上
+    return [self _objectsFromItems:items];
+}
+
+- (void)objectsForKeys:(NSArray<NSString *> *)keys withBlock:(void(^)(NSDictionary<NSString *, id<NSCoding>> *objects))block {
+    if (!block) return;
+    __weak typeof(self) _self = self;
+    dispatch_async(_queue, ^{
+        __strong typeof(_self) self = _self;
+        NSDictionary *objects = [self objectsForKeys:keys];
+        block(objects);
+    });
+}
+
 - (void)objectForKey:(NSString *)key withBlock:(void(^)(NSString *key, id<NSCoding> object))block {
     if (!block) return;
     __weak typeof(self) _self = self;
@@ -325,25 +805,23 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
 }
 
 - (void)setObject:(id<NSCoding>)object forKey:(NSString *)key {
+    [self setObject:object forKey:key withTTL:0];
+}
+
+- (void)setObject:(id<NSCoding>)object forKey:(NSString *)key withTTL:(NSTimeInterval)ttl {
+    if (_readOnly) return;
     if (!key) return;
     if (!object) {
         [self removeObjectForKey:key];
         return;
     }
+    int expireTime = ttl > 0 ? (int)(time(NULL) + ttl) : 0;
     
     NSData *extendedData = [YYDiskCache getExtendedDataFromObject:object];
-    NSData *value = nil;
-    if (_customArchiveBlock) {
-        value = _customArchiveBlock(object);
-    } else {
-        @try {
-            value = [NSKeyedArchiver archivedDataWithRootObject:object];
-        }
-        @catch (NSException *exception) {
-            // nothing to do...
-        }
-    }
+    NSData *value = [self _dataFromObject:object];
     if (!value) return;
+    // 压缩在归档后、选择存储方式前进行，inlineThreshold按压缩后的大小判断
+    value = [self _compressedDataFromData:value];
     NSString *filename = nil;
     if (_kv.type != YYKVStorageTypeSQLite) {
         // 如果超过数据库写入大小限制，生成文件名
@@ -352,8 +830,38 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
         }
     }
     
+    if (_writeCoalescingEnabled && filename.length == 0) {
+        // 小的sqlite写入进入缓冲，按条数/字节/延迟三个上限触发一次事务落盘
+        YYKVStorageItem *item = [YYKVStorageItem new];
+        item.key = key;
+        item.value = value;
+        item.extendedData = extendedData;
+        item.expireTime = expireTime;
+        Lock();
+        if (!_pendingWrites) _pendingWrites = [NSMutableDictionary new];
+        _pendingWrites[key] = item;
+        _pendingWriteBytes += value.length;
+        if (_pendingWrites.count >= kWriteCoalescingMaxCount || _pendingWriteBytes >= kWriteCoalescingMaxBytes) {
+            [self _flushPendingWritesLocked];
+        } else if (!_flushScheduled) {
+            _flushScheduled = YES;
+            __weak typeof(self) _self = self;
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kWriteCoalescingDelay * NSEC_PER_SEC)), _queue, ^{
+                __strong typeof(_self) self = _self;
+                if (!self) return;
+                Lock();
+                self->_flushScheduled = NO;
+                [self _flushPendingWritesLocked];
+                Unlock();
+            });
+        }
+        Unlock();
+        return;
+    }
+
     Lock();
-    [_kv saveItemWithKey:key value:value filename:filename extendedData:extendedData];
+    [_kv saveItemWithKey:key value:value filename:filename extendedData:extendedData expireTime:expireTime];
+    [self _scheduleTrimIfNeededLocked];
     Unlock();
 }
 
@@ -366,9 +874,85 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
     });
 }
 
+- (void)setFileURL:(NSURL *)fileURL forKey:(NSString *)key {
+    [self setFileURL:fileURL forKey:key withTTL:0];
+}
+
+- (void)setFileURL:(NSURL *)fileURL forKey:(NSString *)key withTTL:(NSTimeInterval)ttl {
+    if (_readOnly) return;
+    if (!key) return;
+    if (!fileURL) {
+        [self removeObjectForKey:key];
+        return;
+    }
+    // sqlite类型没有data目录，放不下文件
+    if (_kv.type == YYKVStorageTypeSQLite) return;
+    int expireTime = ttl > 0 ? (int)(time(NULL) + ttl) : 0;
+    Lock();
+    // payload由文件系统硬链接/复制进data目录，不经过归档、压缩和堆内存
+    [_kv saveItemWithKey:key fromFileURL:fileURL filename:[self _filenameForKey:key] extendedData:nil expireTime:expireTime];
+    [self _scheduleTrimIfNeededLocked];
+    Unlock();
+}
+
+- (NSURL *)fileURLForKey:(NSString *)key {
+    if (!key) return nil;
+    ReadLock();
+    NSURL *fileURL = [_kv getItemFileURLForKey:key];
+    ReadUnlock();
+    if (fileURL) [self _scheduleAccessTimeFlushIfNeeded];
+    return fileURL;
+}
+
+- (NSDictionary<NSString *, id<NSCoding>> *)objectsOrderByAccessTimeDescWithCount:(NSUInteger)count {
+    if (count == 0) return [NSDictionary dictionary];
+    ReadLock();
+    NSArray *items = [_kv getItemsOrderByAccessTimeDescWithLimit:count < INT_MAX ? (int)count : INT_MAX];
+    ReadUnlock();
+    // 反归档在锁外进行，不阻塞其它读取；预热的大批量解档也能摊到多个核心上
+    return [self _objectsFromItems:items];
+}
+
+- (void)setObjects:(NSArray<id<NSCoding>> *)objects forKeys:(NSArray<NSString *> *)keys {
+    if (_readOnly) return;
+    if (objects.count != keys.count || keys.count == 0) return;
+    // 归档在锁外完成，锁只保护批量写入
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:keys.count];
+    for (NSUInteger i = 0, max = keys.count; i < max; i++) {
+        id<NSCoding> object = objects[i];
+        NSData *value = [self _dataFromObject:object];
+        if (!value) continue;
+        value = [self _compressedDataFromData:value];
+        YYKVStorageItem *item = [YYKVStorageItem new];
+        item.key = keys[i];
+        item.value = value;
+        item.extendedData = [YYDiskCache getExtendedDataFromObject:object];
+        if (_kv.type != YYKVStorageTypeSQLite && value.length > _inlineThreshold) {
+            item.filename = [self _filenameForKey:keys[i]];
+        }
+        [items addObject:item];
+    }
+    if (items.count == 0) return;
+    Lock();
+    [_kv saveItems:items];
+    [self _scheduleTrimIfNeededLocked];
+    Unlock();
+}
+
+- (void)setObjects:(NSArray<id<NSCoding>> *)objects forKeys:(NSArray<NSString *> *)keys withBlock:(void(^)(void))block {
+    __weak typeof(self) _self = self;
+    dispatch_async(_queue, ^{
+        __strong typeof(_self) self = _self;
+        [self setObjects:objects forKeys:keys];
+        if (block) block();
+    });
+}
+
 - (void)removeObjectForKey:(NSString *)key {
+    if (_readOnly) return;
     if (!key) return;
     Lock();
+    if (_pendingWrites.count) [_pendingWrites removeObjectForKey:key];
     [_kv removeItemForKey:key];
     Unlock();
 }
@@ -383,7 +967,10 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
 }
 
 - (void)removeAllObjects {
+    if (_readOnly) return;
     Lock();
+    [_pendingWrites removeAllObjects];
+    _pendingWriteBytes = 0;
     [_kv removeAllItems];
     Unlock();
 }
@@ -407,15 +994,17 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
             return;
         }
         Lock();
+        [self->_pendingWrites removeAllObjects];
+        self->_pendingWriteBytes = 0;
         [_kv removeAllItemsWithProgressBlock:progress endBlock:end];
         Unlock();
     });
 }
 
 - (NSInteger)totalCount {
-    Lock();
+    ReadLock();
     int count = [_kv getItemsCount];
-    Unlock();
+    ReadUnlock();
     return count;
 }
 
@@ -430,9 +1019,9 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
 }
 
 - (NSInteger)totalCost {
-    Lock();
+    ReadLock();
     int count = [_kv getItemsSize];
-    Unlock();
+    ReadUnlock();
     return count;
 }
 
@@ -506,13 +1095,70 @@ static void _YYDiskCacheSetGlobal(YYDiskCache *cache) {
     else return [NSString stringWithFormat:@"<%@: %p> (%@)", self.class, self, _path];
 }
 
-- (BOOL)errorLogsEnabled {
+- (BOOL)mappedReadEnabled {
+    ReadLock();
+    BOOL enabled = _kv.mappedReadEnabled;
+    ReadUnlock();
+    return enabled;
+}
+
+- (BOOL)defersAccessTimeUpdates {
+    ReadLock();
+    BOOL enabled = _kv.defersAccessTimeUpdates;
+    ReadUnlock();
+    return enabled;
+}
+
+- (void)setDefersAccessTimeUpdates:(BOOL)defersAccessTimeUpdates {
     Lock();
-    BOOL enabled = _kv.errorLogsEnabled;
+    BOOL wasEnabled = _kv.defersAccessTimeUpdates;
+    _kv.defersAccessTimeUpdates = defersAccessTimeUpdates;
+    // 关闭时把已积攒的更新落库，不让它们一直悬着
+    if (wasEnabled && !defersAccessTimeUpdates) [_kv flushAccessTimeUpdates];
     Unlock();
+}
+
+- (void)setMappedReadEnabled:(BOOL)mappedReadEnabled {
+    Lock();
+    _kv.mappedReadEnabled = mappedReadEnabled;
+    Unlock();
+}
+
+- (BOOL)errorLogsEnabled {
+    ReadLock();
+    BOOL enabled = _kv.errorLogsEnabled;
+    ReadUnlock();
     return enabled;
 }
 
+- (YYDiskCacheStatistics)statistics {
+    YYDiskCacheStatistics stats;
+    stats.hitCount = atomic_load_explicit(&_hitCount, memory_order_relaxed);
+    stats.missCount = atomic_load_explicit(&_missCount, memory_order_relaxed);
+    stats.evictionCount = atomic_load_explicit(&_evictionCount, memory_order_relaxed);
+    stats.expiredCount = atomic_load_explicit(&_expiredCount, memory_order_relaxed);
+    return stats;
+}
+
+- (void)resetStatistics {
+    atomic_store_explicit(&_hitCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_missCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_evictionCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_expiredCount, 0, memory_order_relaxed);
+}
+
+- (void)setEventDrivenTrimEnabled:(BOOL)eventDrivenTrimEnabled {
+    Lock();
+    BOOL wasEnabled = _eventDrivenTrimEnabled;
+    _eventDrivenTrimEnabled = eventDrivenTrimEnabled;
+    Unlock();
+    if (wasEnabled && !eventDrivenTrimEnabled) {
+        [self _trimRecursively]; // 恢复定时轮询
+    } else if (!wasEnabled && eventDrivenTrimEnabled) {
+        [self _trimInBackground]; // 切换时先清到限制以下
+    }
+}
+
 - (void)setErrorLogsEnabled:(BOOL)errorLogsEnabled {
     Lock();
     _kv.errorLogsEnabled = errorLogsEnabled;
@@ -55,6 +55,30 @@ NS_ASSUME_NONNULL_BEGIN
  拓展数据
  */
 @property (nullable, nonatomic, strong) NSData *extendedData; ///< extended data (nil if no extended data)
+
+/**
+ 消息在slab日志文件中的偏移（非slab存储时为-1）
+ */
+@property (nonatomic) long long slabOffset;                 ///< offset in the slab file (-1 if not slab-backed)
+
+/**
+ 消息过期的unix时间戳（0表示不过期）
+ */
+@property (nonatomic) int expireTime;                       ///< expire unix timestamp (0 if never expires)
+@end
+
+/**
+ YYKVStorageSlowOp is a record of one storage operation that exceeded
+ `YYKVStorage.slowOperationThreshold`. See `slowOperations`.
+ YYKVStorageSlowOp 是一条耗时超过 `slowOperationThreshold` 的存储操作记录
+ 见 `slowOperations`
+ */
+@interface YYKVStorageSlowOp : NSObject
+@property (nonatomic, strong) NSString *operation;  ///< operation name ("dbSave", "dbCheckpoint", "fileRead", "fileWrite", "slabAppend", "slabRead")
+@property (nonatomic) NSUInteger keyLength;         ///< length of the key (0 for operations without a key)
+@property (nonatomic) NSUInteger bytes;             ///< number of bytes involved
+@property (nonatomic) NSTimeInterval duration;      ///< duration in seconds
+@property (nonatomic) NSTimeInterval timestamp;     ///< absolute time when the operation finished
 @end
 
 /**
@@ -96,6 +120,42 @@ typedef NS_ENUM(NSUInteger, YYKVStorageType) {
     /// The `value` is stored in file system or sqlite based on your choice.
     /// 根据选择选取存入方式
     YYKVStorageTypeMixed = 2,
+    
+    /// The `value` is appended to a single slab log file (offset recorded in
+    /// sqlite), unless a filename is given, in which case it is stored as a
+    /// file like YYKVStorageTypeMixed. Writing a small value costs a single
+    /// sequential append instead of a blob rewrite; space freed by removed or
+    /// overwritten values is reclaimed by background compaction.
+    /// 消息追加存入单个slab日志文件（偏移记录在sqlite中）
+    /// 指定了filename时和 YYKVStorageTypeMixed 一样存入文件
+    /// 小value的写入只需一次顺序追加；删除或覆盖产生的死空间由后台压缩回收
+    YYKVStorageTypeSlab = 3,
+};
+
+/**
+ Type of the in-memory key index used to short-circuit negative lookups.
+ 
+ 用于让未命中的查询免于访问数据库的内存key索引类型
+ */
+typedef NS_ENUM(NSUInteger, YYKVStorageKeyIndexType) {
+    
+    /// No key index, every lookup goes to sqlite.
+    /// 不维护索引，所有查询都访问sqlite
+    YYKVStorageKeyIndexTypeNone = 0,
+    
+    /// A bloom filter over the live keys (~16 bits per key). A negative
+    /// answer is exact; a positive answer may rarely be a false positive
+    /// and falls through to sqlite. Removed keys are not cleared from the
+    /// filter until it is rebuilt.
+    /// 对存活key维护bloom过滤器（每个key约16位）
+    /// 否定回答是精确的；肯定回答存在极小的误判率，会继续查询sqlite
+    /// 被删除的key在重建前不会从过滤器中清除
+    YYKVStorageKeyIndexTypeBloom = 1,
+    
+    /// An exact hash set of the live keys. Both answers are exact, at the
+    /// cost of keeping every key string in memory.
+    /// 对存活key维护精确哈希集合，两种回答都是精确的，代价是所有key常驻内存
+    YYKVStorageKeyIndexTypeExact = 2,
 };
 
 
@@ -111,15 +171,19 @@ typedef NS_ENUM(NSUInteger, YYKVStorageType) {
  You may compile the latest version of sqlite and ignore the libsqlite3.dylib in
  iOS system to get 2x~4x speed up.
  
- @warning The instance of this class is *NOT* thread safe, you need to make sure 
- that there's only one thread to access the instance at the same time. If you really 
- need to process large amounts of data in multi-thread, you should split the data
- to multiple KVStorage instance (sharding).
+ @warning The instance of this class is *NOT* thread safe for mutation, you need
+ to make sure that there's only one thread mutating the instance at the same time.
+ The get methods may be called from multiple threads concurrently with each other
+ (but not with a mutation): database access is serialized internally while file
+ reads proceed in parallel. If you really need to process large amounts of data
+ in multi-thread, you should split the data to multiple KVStorage instance (sharding).
  
  消息写入file/sqlite的管理类
  @discussion 键值对的方式将消息存入文件和sqlite 使用`initWithPath:type:`进行初始化
  初始化后 不要再对生成的path进行读写操作 使用最新的sqlite版本获取2-4倍的速度提升
- 产生的实例并不是线程安全的，应该在同一时间在同一的线程使用，数据较大时，应该对数据进行拆分成多个片段进行存储
+ 产生的实例的写入并不是线程安全的，同一时间只能有一个线程执行写入
+ get方法之间可以并发调用（但不能和写入并发）：db访问在内部串行，文件读取并行进行
+ 数据较大时，应该对数据进行拆分成多个片段进行存储
  */
 @interface YYKVStorage : NSObject
 
@@ -138,11 +202,105 @@ typedef NS_ENUM(NSUInteger, YYKVStorageType) {
  */
 @property (nonatomic, readonly) YYKVStorageType type;  ///< The type of this storage.
 
+/**
+ Whether this storage was opened in read-only attach mode.
+ See `initWithPath:type:readOnly:`.
+ 是否以只读附着模式打开，见 `initWithPath:type:readOnly:`
+ */
+@property (nonatomic, readonly, getter=isReadOnly) BOOL readOnly;
+
 /**
  是否打印log
  */
 @property (nonatomic) BOOL errorLogsEnabled;           ///< Set `YES` to enable error logs for debug.
 
+/**
+ Operations slower than this threshold (in seconds) are recorded into a ring
+ buffer of the last 64 slow operations, retrievable with `slowOperations`.
+ 0 (the default) disables recording. The hot paths are also wrapped in
+ os_signpost intervals (subsystem "com.ibireme.cache", category "YYKVStorage")
+ so individual sqlite statements and file I/O calls show up in Instruments.
+
+ 耗时超过该阈值（秒）的操作会记录进环形缓冲（保留最近64条），用 `slowOperations` 导出
+ 默认值0表示不记录。热路径同时包裹了os_signpost区间
+ （subsystem "com.ibireme.cache"，category "YYKVStorage"）
+ 可以在Instruments里看到每条sqlite语句和文件读写的耗时
+ */
+@property (nonatomic) NSTimeInterval slowOperationThreshold;
+
+/**
+ The inline-vs-file crossover size (in bytes) learned from measured reads,
+ or 0 when nothing has been learned yet.
+
+ @discussion Every real read feeds a per-size-bucket latency average for
+ inline blob reads and file reads; the recommendation is the lower bound of
+ the smallest bucket where the file read is measured to be faster. A bucket
+ only counts once both sides have at least 32 samples. The learned value is
+ persisted to the manifest during `performMaintenance`, so after a restart
+ this returns the previous verdict until fresh measurements override it.
+ See `YYDiskCache.autoTunesInlineThreshold` for the consumer side.
+
+ 从真实读取的耗时测量中学习到的inline/文件存储分界尺寸（字节），还没学到时返回0
+ 每次真实读取都按尺寸分桶记录blob读与文件读的耗时均值
+ 建议值取文件读实测更快的最小分桶的下界，每侧采样满32次的分桶才参与判断
+ 学到的值在 `performMaintenance` 时持久化到manifest，重启后沿用上次的结论
+ 消费端见 `YYDiskCache.autoTunesInlineThreshold`
+ */
+@property (nonatomic, readonly) NSUInteger recommendedInlineThreshold;
+
+/**
+ If `YES`, file-backed values are read as mmap-backed NSData (bytes are paged
+ in on demand) instead of being copied through a malloc buffer. Default is `NO`.
+
+ @discussion This avoids duplicating large values in anonymous memory on the
+ read path. The mapping stays valid even if the item is removed afterwards,
+ because the unlinked file is kept alive by the mapping. Mapped reads fall
+ back to a plain read when the file cannot be safely mapped.
+
+ 如果是 YES 文件类型的value通过mmap映射成NSData返回（按需换页）
+ 避免读取时在匿名内存中复制一份大value，默认值是 NO
+ item随后被删除时映射依然有效（被unlink的文件会被映射保留）
+ 无法安全映射时回退为普通读取
+ */
+@property (nonatomic) BOOL mappedReadEnabled;          ///< Set `YES` to mmap file-backed values on read.
+
+/**
+ If `YES`, access-time bookkeeping on the read path is deferred: a cache hit
+ adds its key to an in-memory dirty set instead of issuing an UPDATE, and the
+ set is flushed as one batched UPDATE when it grows large and before any query
+ or trim that orders by access time. Default is `NO`.
+
+ @discussion On a read-heavy screen every hit otherwise pays a durable sqlite
+ write plus WAL traffic just for LRU ordering. Deferred updates trade a few
+ seconds of access-time accuracy — plenty for trim ordering — for a write-free
+ read path. The owner should also call `flushAccessTimeUpdates` periodically
+ under its write exclusion (YYDiskCache schedules this a few seconds after a
+ hit). Pending updates are lost if the process is killed, which only makes
+ recently read items look slightly older to the LRU trim.
+
+ 如果是 YES 读命中不再立即UPDATE访问时间，而是把key记入内存中的脏集合
+ 脏集合在攒满上限、或任何按访问时间排序的查询/修剪前合并成一条批量UPDATE
+ 默认值是 NO
+ 读密集的场景下，否则每次命中都要为LRU排序付出一次持久化写入和WAL流量
+ 代价是访问时间有几秒误差——对修剪排序来说足够了
+ 持有方还应在写排他下定期调用 `flushAccessTimeUpdates`（YYDiskCache会在命中后几秒调度一次）
+ 进程被杀时未落库的更新会丢失，后果只是最近读过的item在LRU修剪眼里显得略旧
+ */
+@property (nonatomic) BOOL defersAccessTimeUpdates;    ///< Set `YES` to batch access-time updates on read.
+
+/**
+ Type of the in-memory key index. Default is YYKVStorageKeyIndexTypeNone.
+
+ @discussion Setting this builds the index immediately by scanning the keys in
+ the manifest; it is then kept in sync by the save/remove methods, so a lookup
+ for a key that was never stored answers without touching sqlite.
+
+ 内存key索引类型，默认是 YYKVStorageKeyIndexTypeNone
+ 设置后立即扫描manifest中的key建立索引，之后由保存/删除方法维护
+ 查询从未存过的key时无需访问sqlite
+ */
+@property (nonatomic) YYKVStorageKeyIndexType keyIndexType; ///< The type of the in-memory key index.
+
 #pragma mark - 初始化
 ///=============================================================================
 /// @name Initializer
@@ -151,23 +309,43 @@ typedef NS_ENUM(NSUInteger, YYKVStorageType) {
 + (instancetype)new UNAVAILABLE_ATTRIBUTE;
 
 /**
- The designated initializer. 
- 
+ Convenience initializer, equivalent to `initWithPath:type:readOnly:` with
+ readOnly:NO. See that method for details.
+
+ 便利的实例化方法，等价于 readOnly 为 NO 的 `initWithPath:type:readOnly:`
+ */
+- (nullable instancetype)initWithPath:(NSString *)path type:(YYKVStorageType)type;
+
+/**
+ The designated initializer.
+
  @param path  Full path of a directory in which the storage will write data. If
-    the directory is not exists, it will try to create one, otherwise it will 
+    the directory is not exists, it will try to create one, otherwise it will
     read the data in this directory.
- @param type  The storage type. After first initialized you should not change the 
+ @param type  The storage type. After first initialized you should not change the
     type of the specified path.
+ @param readOnly If `YES`, the storage attaches to an existing path without
+    ever writing: the manifest is opened with SQLITE_OPEN_READONLY and a 64MB
+    mmap window, the slab file is opened O_RDONLY, and nothing is created,
+    repaired, trimmed or checkpointed. All mutation methods return NO; reads
+    do not refresh access times and leave expired/broken rows for the owning
+    process to collect. This is how an app extension can read a cache that the
+    main app keeps a writable instance on, without fighting over sqlite locks.
  @return  A new storage object, or nil if an error occurs.
- @warning Multiple instances with the same path will make the storage unstable.
- 
+ @warning Multiple writable instances with the same path will make the storage
+    unstable. Read-only instances may coexist with one writable instance.
+
  推荐的实例化方法
  path  写数据的路径. 如果路径存在，则会在此路径读写数据 否则建立一个新路径
  type  存储类型  一旦设置后不要修改
+ readOnly  如果是 YES 则以只读模式附着到已有路径：manifest以SQLITE_OPEN_READONLY
+    加64MB的mmap窗口打开，slab文件以O_RDONLY打开，不创建、不修复、不清扫
+    所有修改方法返回NO，读取不刷新访问时间，过期/损坏的记录留给持有写实例的进程回收
+    App Extension可以用这种方式读取主App持有可写实例的缓存，不会争抢sqlite锁
  返回一个存储管理实例, 发生错误返回nil
- 多个实例操作同一个路径 会导致错误
+ 多个可写实例操作同一个路径会导致错误，只读实例可以和一个可写实例共存
  */
-- (nullable instancetype)initWithPath:(NSString *)path type:(YYKVStorageType)type NS_DESIGNATED_INITIALIZER;
+- (nullable instancetype)initWithPath:(NSString *)path type:(YYKVStorageType)type readOnly:(BOOL)readOnly NS_DESIGNATED_INITIALIZER;
 
 
 #pragma mark - 保存消息
@@ -249,6 +427,117 @@ typedef NS_ENUM(NSUInteger, YYKVStorageType) {
                filename:(nullable NSString *)filename
            extendedData:(nullable NSData *)extendedData;
 
+/**
+ Save an item with an expire timestamp, or update the item with 'key' if it
+ already exists.
+ 
+ @discussion Same as `saveItemWithKey:value:filename:extendedData:`, with an
+ expire unix timestamp stored in the manifest. Expiration is lazy: an expired
+ item is treated as not found by the get methods, and the row is reclaimed by
+ `removeExpiredItems`.
+ 
+ @param key           The key, should not be empty (nil or zero length).
+ @param value         The key, should not be empty (nil or zero length).
+ @param filename      The filename.
+ @param extendedData  The extended data for this item (pass nil to ignore it).
+ @param expireTime    The expire unix timestamp, 0 means never expires.
+ 
+ @return Whether succeed.
+ 
+ 保存带过期时间的item key值存在时更新item
+ 和 `saveItemWithKey:value:filename:extendedData:` 一致，过期时间戳会存入manifest
+ 过期采用惰性回收：get方法把过期的item当作不存在，记录由 `removeExpiredItems` 回收
+ expireTime  过期的unix时间戳，0表示不过期
+ 返回是否成功
+ */
+- (BOOL)saveItemWithKey:(NSString *)key
+                  value:(NSData *)value
+               filename:(nullable NSString *)filename
+           extendedData:(nullable NSData *)extendedData
+             expireTime:(int)expireTime;
+
+/**
+ Save an item by streaming an existing file into the store, or update the
+ item with 'key' if it already exists.
+
+ @discussion Unlike `saveItemWithKey:value:filename:extendedData:`, the value
+ is never materialized in memory: the source file is hard-linked into the data
+ directory when it is on the same volume, and copied by the file system
+ otherwise. Use this for large payloads (video segments, downloads) that would
+ otherwise be doubled in the heap while saving. The `type` should not be
+ YYKVStorageTypeSQLite. Reading the item back with `getItemForKey:` will load
+ the value into memory as usual; use `getItemFileURLForKey:` to access the
+ payload without loading it.
+
+ @param key           The key, should not be empty (nil or zero length).
+ @param fileURL       A file URL of the source file, should not be nil.
+ @param filename      The filename, should not be empty (nil or zero length).
+ @param extendedData  The extended data for this item (pass nil to ignore it).
+
+ @return Whether succeed.
+
+ 把一个已存在的文件流式保存为item key值存在时更新item
+ 和 `saveItemWithKey:value:filename:extendedData:` 不同，value全程不进内存：
+ 源文件在同一卷时硬链接进data目录，跨卷时由文件系统复制
+ 适合大payload（视频分片、下载文件），避免保存时在堆里多出一份拷贝
+ 存储类型不能是 YYKVStorageTypeSQLite
+ 用 `getItemForKey:` 读取时value仍会载入内存，不想载入可用 `getItemFileURLForKey:`
+ key           key值不能为空
+ fileURL       源文件的文件URL，不能为nil
+ filename      文件名，不能为空
+ extendedData  item的拓展数据 如果是nil则忽略
+ 返回是否成功
+ */
+- (BOOL)saveItemWithKey:(NSString *)key
+            fromFileURL:(NSURL *)fileURL
+               filename:(NSString *)filename
+           extendedData:(nullable NSData *)extendedData;
+
+/**
+ Save an item by streaming an existing file into the store, with an expire
+ timestamp.
+
+ @discussion Same as `saveItemWithKey:fromFileURL:filename:extendedData:`,
+ with an expire unix timestamp stored in the manifest.
+
+ @param key           The key, should not be empty (nil or zero length).
+ @param fileURL       A file URL of the source file, should not be nil.
+ @param filename      The filename, should not be empty (nil or zero length).
+ @param extendedData  The extended data for this item (pass nil to ignore it).
+ @param expireTime    The expire unix timestamp, 0 means never expires.
+
+ @return Whether succeed.
+
+ 把一个已存在的文件流式保存为带过期时间的item
+ 和 `saveItemWithKey:fromFileURL:filename:extendedData:` 一致，过期时间戳会存入manifest
+ expireTime  过期的unix时间戳，0表示不过期
+ 返回是否成功
+ */
+- (BOOL)saveItemWithKey:(NSString *)key
+            fromFileURL:(NSURL *)fileURL
+               filename:(NSString *)filename
+           extendedData:(nullable NSData *)extendedData
+             expireTime:(int)expireTime;
+
+/**
+ Save multiple items in a single sqlite transaction, or update the items
+ whose 'key' already exists.
+
+ @discussion Each item is saved with the same rules as `saveItem:`, but all
+ the manifest rows are committed in one BEGIN/COMMIT transaction, so a burst
+ of writes pays one WAL sync instead of one per item.
+
+ @param items An array of items.
+ @return Whether all items were saved successfully.
+
+ 在一个sqlite事务中批量保存items，key值存在时更新item
+ 每个item的保存规则和 `saveItem:` 一致，但所有记录在一个 BEGIN/COMMIT 事务中提交
+ 一批写入只付出一次WAL同步的开销，而不是每条一次
+ items item数组
+ 返回是否全部保存成功
+ */
+- (BOOL)saveItems:(NSArray<YYKVStorageItem *> *)items;
+
 #pragma mark - 删除消息
 ///=============================================================================
 /// @name Remove Items
@@ -329,6 +618,16 @@ typedef NS_ENUM(NSUInteger, YYKVStorageType) {
  */
 - (BOOL)removeItemsToFitCount:(int)maxCount;
 
+/**
+ Remove all expired items.
+ 
+ @return Whether succeed.
+ 
+ 删除所有已过期的items
+ 返回是否删除成功
+ */
+- (BOOL)removeExpiredItems;
+
 /**
  Remove all items in background queue.
  
@@ -403,6 +702,34 @@ typedef NS_ENUM(NSUInteger, YYKVStorageType) {
  */
 - (nullable NSData *)getItemValueForKey:(NSString *)key;
 
+/**
+ Get a file URL for the value of a file-backed item.
+
+ @discussion Returns a URL pointing at the item's file inside the data
+ directory, so a large value can be handed to readers (e.g. AVPlayer,
+ NSFileHandle) without loading it into memory. Returns nil for items stored
+ inline in sqlite or in the slab file. The item's last access time is
+ refreshed, like `getItemForKey:`.
+
+ @warning The file belongs to the store: it may disappear once the item is
+ removed or trimmed. Hard-link it or finish reading before releasing control.
+
+ @param key A specified key.
+ @return A file URL for the item's value, or nil if not exists / not
+ file-backed / error occurs.
+
+ 获取文件类型item的value的文件URL
+ 返回指向data目录内该item文件的URL，大value可以直接交给读取方
+ （如 AVPlayer、NSFileHandle）而不经过内存
+ value内联在sqlite或slab中的item返回nil
+ 和 `getItemForKey:` 一样会刷新最后访问时间
+ @warning 文件归存储所有：item被删除或清理后文件随时可能消失
+ 需要长期持有就先硬链接出去，或在失去控制前读完
+ key  特定的key值
+ 返回value的文件URL，不存在/非文件类型/发生错误返回nil
+ */
+- (nullable NSURL *)getItemFileURLForKey:(NSString *)key;
+
 /**
  Get items with an array of keys.
  
@@ -415,6 +742,37 @@ typedef NS_ENUM(NSUInteger, YYKVStorageType) {
  */
 - (nullable NSArray<YYKVStorageItem *> *)getItemForKeys:(NSArray<NSString *> *)keys;
 
+/**
+ Get the most recently accessed items, ordered by last access time descending.
+ Expired items are skipped. The access times are not refreshed by this query.
+
+ @param limit The maximum number of items to return.
+ @return The items, or nil if the store is empty or an error occurs.
+
+ 获取最近访问的limit条item，按最后访问时间降序排列
+ 跳过已过期的记录，此查询不会刷新访问时间
+ */
+- (nullable NSArray<YYKVStorageItem *> *)getItemsOrderByAccessTimeDescWithLimit:(int)limit;
+
+/**
+ Enumerate all items ordered by last access time ascending, walking a single
+ cursor in bounded batches so a full-store scan runs at constant memory.
+ Expired items are skipped, and access times are not refreshed. Set *stop to
+ YES inside the block to terminate the enumeration early.
+
+ @warning Item values are loaded one batch at a time; do not retain the whole
+    set in the block if you need constant memory. This method may blocks the
+    calling thread until finished.
+
+ @param block A block applied to each item in turn.
+
+ 按最后访问时间升序枚举所有item，内部用单个游标分批取出，
+ 全量扫描也只占用常量内存。跳过已过期的记录，不刷新访问时间。
+ 在block内把*stop置为YES可提前终止枚举。
+ block 依次应用到每个item上的block
+ */
+- (void)enumerateItemsOrderByAccessTimeAscUsingBlock:(void (^)(YYKVStorageItem *item, BOOL *stop))block;
+
 /**
  Get item infomartions with an array of keys.
  The `value` in items will be ignored.
@@ -477,6 +835,70 @@ typedef NS_ENUM(NSUInteger, YYKVStorageType) {
  */
 - (int)getItemsSize;
 
+#pragma mark - 维护
+///=============================================================================
+/// @name Maintenance
+///=============================================================================
+
+/**
+ Flush the pending access-time updates accumulated while
+ `defersAccessTimeUpdates` is `YES`, as one batched UPDATE.
+
+ @discussion Runs automatically when the dirty set grows large, before
+ access-time-ordered queries and trims, and on dealloc. The flush is a write:
+ like the save/remove methods it must not run concurrently with other writes,
+ so call it under the same exclusion you use for mutations (YYDiskCache calls
+ it while holding its write lock). Call it before the app terminates so the
+ LRU ordering survives the restart.
+
+ 把 `defersAccessTimeUpdates` 开启期间积攒的访问时间合并成一条批量UPDATE落库
+ 脏集合攒满、按访问时间排序的查询/修剪前以及dealloc时会自动执行
+ 回写本身是一次写入：和保存/删除方法一样不能与其它写入并发
+ 调用时要拿着和写入相同的排他（YYDiskCache在持有写锁时调用）
+ 应用退出前调用一次，LRU顺序就能完整保留到下次启动
+ */
+- (void)flushAccessTimeUpdates;
+
+/**
+ Run the sqlite maintenance pass if the bookkeeping says it is due.
+
+ @discussion Maintenance is considered due when the WAL file has grown past a
+ few megabytes (checkpointing is falling behind) or enough rows have been
+ deleted since the last pass to make the planner statistics stale. Cheap to
+ call; returns immediately when nothing is due.
+
+ @return `YES` if maintenance ran, `NO` if it was not needed.
+
+ 按需执行一次sqlite维护
+ wal文件超过几MB（checkpoint落后了）或上次维护以来删除的行数过多（统计信息过时）
+ 时才真正执行，否则立即返回，可以放心频繁调用
+ 返回是否真的执行了维护
+ */
+- (BOOL)performMaintenanceIfNeeded;
+
+/**
+ Run the sqlite maintenance pass unconditionally: checkpoint and truncate the
+ WAL, vacuum when a quarter of the pages are free, refresh the planner
+ statistics, and persist the learned inline threshold.
+
+ 无条件执行一次sqlite维护：合并并截断wal、空闲页过多时vacuum、
+ 重建统计信息、持久化学习到的inline阈值
+ */
+- (void)performMaintenance;
+
+#pragma mark - Instrumentation
+///=============================================================================
+/// @name Instrumentation
+///=============================================================================
+
+/**
+ Returns the recorded slow operations, oldest first.
+ See `slowOperationThreshold`.
+
+ 返回记录下来的慢操作，按时间从旧到新排列，见 `slowOperationThreshold`
+ */
+- (NSArray<YYKVStorageSlowOp *> *)slowOperations;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -12,6 +12,9 @@
 #import "YYKVStorage.h"
 #import <UIKit/UIKit.h>
 #import <time.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <pthread.h>
 
 #if __has_include(<sqlite3.h>)
 #import <sqlite3.h>
@@ -36,6 +39,85 @@ static NSString *const kDBShmFileName = @"manifest.sqlite-shm"; /// Shm文件名
 static NSString *const kDBWalFileName = @"manifest.sqlite-wal"; /// wal文件名
 static NSString *const kDataDirectoryName = @"data";            /// 数据路径名
 static NSString *const kTrashDirectoryName = @"trash";          /// 回收站路径名
+static NSString *const kSlabFileName = @"__slab.data";          /// slab日志文件名
+static NSString *const kSlabTmpFileName = @"__slab.data.tmp";   /// slab压缩时的临时文件名
+
+static const NSUInteger kSlabCompactionCheckInterval = 128;         /// 每写入多少条检查一次slab压缩
+static const int64_t kSlabCompactionMinDeadBytes = 4 * 1024 * 1024; /// 触发slab压缩的最小死空间
+
+static const NSUInteger kSlowOpRingCapacity = 64;   /// 慢操作环形缓冲的容量
+
+static const long long kMaintenanceWALSizeThreshold = 4 * 1024 * 1024;  /// 触发维护的wal文件大小
+static const NSUInteger kMaintenanceDeleteCountThreshold = 10000;       /// 触发维护的累计删除行数
+
+static const NSUInteger kAccessTimeFlushMaxCount = 256;     /// 积攒多少个脏key就立即批量回写访问时间
+
+static const NSUInteger kIOProfileBucketCount = 16;     /// 读取画像的对数尺寸分桶数量
+static const uint32_t kIOProfileMinSamples = 32;        /// 给出阈值建议前每侧至少需要的采样数
+static NSString *const kMetaKeyInlineThreshold = @"learned_inline_threshold";   /// meta表里学习到的阈值的key
+
+/**
+ 慢操作环形缓冲里的一条记录，记录时只写C结构，不做任何ObjC分配
+ */
+typedef struct {
+    const char *operation;      /// 操作名（静态字符串）
+    NSUInteger keyLength;       /// key的长度（没有key的操作为0）
+    NSUInteger bytes;           /// 涉及的字节数
+    NSTimeInterval duration;    /// 耗时（秒）
+    NSTimeInterval timestamp;   /// 操作结束时的绝对时间（CFAbsoluteTimeGetCurrent）
+} _YYKVStorageSlowOpRecord;
+
+/**
+ 一个尺寸分桶的读取画像：blob读与文件读各自耗时的指数移动平均
+ 分桶i覆盖尺寸在 [2^i, 2^(i+1)) 字节的value
+ */
+typedef struct {
+    double dbAvg;           /// inline blob读取耗时的EMA（秒）
+    double fileAvg;         /// 文件读取耗时的EMA（秒）
+    uint32_t dbSamples;     /// blob读取的采样数
+    uint32_t fileSamples;   /// 文件读取的采样数
+} _YYKVStorageIOProfileBucket;
+
+static inline NSUInteger _YYKVStorageIOProfileBucketForSize(NSUInteger size) {
+    NSUInteger bucket = 0;
+    while (size > 1 && bucket + 1 < kIOProfileBucketCount) {
+        size >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+#if __has_include(<os/signpost.h>)
+#import <os/signpost.h>
+#define YYKVStorageHasSignpost 1
+#endif
+
+#if YYKVStorageHasSignpost
+/**
+ signpost的log句柄，Instruments里按subsystem "com.ibireme.cache" 过滤
+ */
+static os_log_t _YYKVStorageSignpostLog(void) API_AVAILABLE(ios(12.0)) {
+    static os_log_t log = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        log = os_log_create("com.ibireme.cache", "YYKVStorage");
+    });
+    return log;
+}
+#define YYKVStorageSignpostBegin(name) \
+    os_signpost_id_t signpostID = 0; \
+    if (@available(iOS 12.0, *)) { \
+        signpostID = os_signpost_id_generate(_YYKVStorageSignpostLog()); \
+        os_signpost_interval_begin(_YYKVStorageSignpostLog(), signpostID, name); \
+    }
+#define YYKVStorageSignpostEnd(name) \
+    if (@available(iOS 12.0, *)) { \
+        os_signpost_interval_end(_YYKVStorageSignpostLog(), signpostID, name); \
+    }
+#else
+#define YYKVStorageSignpostBegin(name)
+#define YYKVStorageSignpostEnd(name)
+#endif
 
 
 /*
@@ -64,6 +146,18 @@ static NSString *const kTrashDirectoryName = @"trash";          /// 回收站路
  create index if not exists last_access_time_idx on manifest(last_access_time);
  */
 
+/// key索引使用的64位FNV-1a哈希，bloom的两个探测位从高低32位派生
+static uint64_t _YYKeyIndexHash(NSString *key) {
+    uint64_t hash = 0xcbf29ce484222325UL;
+    const char *str = key.UTF8String;
+    if (str) {
+        while (*str) {
+            hash = (hash ^ (uint8_t)*str++) * 0x100000001b3UL;
+        }
+    }
+    return hash;
+}
+
 /// Returns nil in App Extension.
 /// 返回Application 如果是App Extension返回nil
 static UIApplication *_YYSharedApplication() {
@@ -85,6 +179,9 @@ static UIApplication *_YYSharedApplication() {
 @implementation YYKVStorageItem
 @end
 
+@implementation YYKVStorageSlowOp
+@end
+
 @implementation YYKVStorage {
     dispatch_queue_t _trashQueue;
     
@@ -97,8 +194,95 @@ static UIApplication *_YYSharedApplication() {
     CFMutableDictionaryRef _dbStmtCache;
     NSTimeInterval _dbLastOpenErrorTime;
     NSUInteger _dbOpenErrorCount;
+
+    int _slabFD;                    /// slab日志文件的fd，未打开时为-1
+    int64_t _slabEnd;               /// slab日志文件的末尾偏移
+    pthread_mutex_t _slabOpenLock;  /// 保护slab文件的惰性打开（可能被并发的首次读取同时触发）
+    NSUInteger _slabOpsSinceCompactionCheck;    /// 距离上次压缩检查的写入条数
+    BOOL _slabCompactionPending;    /// 在事务中触发的压缩被推迟，事务结束后补做
+
+    uint64_t *_bloomBits;           /// bloom过滤器位数组，未启用时为NULL
+    uint64_t _bloomBitMask;         /// 位数组大小 - 1（大小为2的幂）
+    NSMutableSet *_keySet;          /// 精确key集合，未启用时为nil
+
+    pthread_mutex_t _dbLock;        /// 并发读取时串行化db访问，文件和slab读取不受它保护
+
+    _YYKVStorageSlowOpRecord *_slowOps; /// 慢操作环形缓冲
+    NSUInteger _slowOpIndex;            /// 下一条慢操作记录的序号（持续递增）
+    pthread_mutex_t _slowOpLock;        /// 保护慢操作环形缓冲
+
+    NSUInteger _dbDeletesSinceMaintenance;  /// 上次维护以来删除的行数，用于决定是否需要ANALYZE
+
+    _YYKVStorageIOProfileBucket *_ioProfile;    /// 按尺寸分桶的读取画像
+    pthread_mutex_t _ioProfileLock;             /// 保护读取画像
+    NSUInteger _learnedInlineThreshold;         /// meta表里持久化的已学习阈值，0表示还没有
+
+    NSMutableSet *_dirtyAccessKeys;         /// 读命中后待批量回写访问时间的key，_dbLock保护
+}
+
+
+/**
+ 耗时超过 `slowOperationThreshold` 的操作进入环形缓冲，供 `slowOperations` 导出
+ 阈值未设置时直接返回，热路径上只有一次时间读取的开销
+ */
+- (void)_recordOp:(const char *)operation keyLength:(NSUInteger)keyLength bytes:(NSUInteger)bytes begin:(NSTimeInterval)begin {
+    NSTimeInterval threshold = _slowOperationThreshold;
+    if (threshold <= 0) return;
+    NSTimeInterval end = CFAbsoluteTimeGetCurrent();
+    NSTimeInterval duration = end - begin;
+    if (duration < threshold) return;
+    pthread_mutex_lock(&_slowOpLock);
+    _YYKVStorageSlowOpRecord *record = &_slowOps[_slowOpIndex % kSlowOpRingCapacity];
+    record->operation = operation;
+    record->keyLength = keyLength;
+    record->bytes = bytes;
+    record->duration = duration;
+    record->timestamp = end;
+    _slowOpIndex++;
+    pthread_mutex_unlock(&_slowOpLock);
+}
+
+/**
+ 把一次真实读取的耗时记入画像（piggyback在正常读取上，没有额外I/O）
+ */
+- (void)_ioProfileRecordReadWithSize:(NSUInteger)size duration:(NSTimeInterval)duration fromFile:(BOOL)fromFile {
+    if (size == 0 || duration <= 0) return;
+    NSUInteger bucket = _YYKVStorageIOProfileBucketForSize(size);
+    pthread_mutex_lock(&_ioProfileLock);
+    _YYKVStorageIOProfileBucket *profile = &_ioProfile[bucket];
+    if (fromFile) {
+        profile->fileAvg += (duration - profile->fileAvg) / 8; // EMA，alpha = 1/8
+        if (profile->fileSamples < UINT32_MAX) profile->fileSamples++;
+    } else {
+        profile->dbAvg += (duration - profile->dbAvg) / 8;
+        if (profile->dbSamples < UINT32_MAX) profile->dbSamples++;
+    }
+    pthread_mutex_unlock(&_ioProfileLock);
+}
+
+/**
+ 画像给出的新鲜建议：文件读实测比blob读更快的最小分桶的下界
+ 两侧采样都不足的分桶被跳过，没有任何结论时返回0
+ */
+- (NSUInteger)_ioProfileRecommendation {
+    NSUInteger recommended = 0;
+    pthread_mutex_lock(&_ioProfileLock);
+    for (NSUInteger i = 0; i < kIOProfileBucketCount; i++) {
+        _YYKVStorageIOProfileBucket *profile = &_ioProfile[i];
+        if (profile->dbSamples < kIOProfileMinSamples || profile->fileSamples < kIOProfileMinSamples) continue;
+        if (profile->fileAvg < profile->dbAvg) {
+            recommended = (NSUInteger)1 << i;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_ioProfileLock);
+    return recommended;
 }
 
+- (NSUInteger)recommendedInlineThreshold {
+    NSUInteger recommended = [self _ioProfileRecommendation];
+    return recommended ? recommended : _learnedInlineThreshold;
+}
 
 #pragma mark - db
 
@@ -107,8 +291,13 @@ static UIApplication *_YYSharedApplication() {
  */
 - (BOOL)_dbOpen {
     if (_db) return YES;
-    
-    int result = sqlite3_open(_dbPath.UTF8String, &_db);
+
+    int result;
+    if (_readOnly) {
+        result = sqlite3_open_v2(_dbPath.UTF8String, &_db, SQLITE_OPEN_READONLY, NULL);
+    } else {
+        result = sqlite3_open(_dbPath.UTF8String, &_db);
+    }
     if (result == SQLITE_OK) {
         CFDictionaryKeyCallBacks keyCallbacks = kCFCopyStringDictionaryKeyCallBacks;
         CFDictionaryValueCallBacks valueCallbacks = {0};
@@ -185,18 +374,90 @@ static UIApplication *_YYSharedApplication() {
  开启 SQLite 的 WAL 模式
  */
 - (BOOL)_dbInitialize {
-    NSString *sql = @"pragma journal_mode = wal; pragma synchronous = normal; create table if not exists manifest (key text, filename text, size integer, inline_data blob, modification_time integer, last_access_time integer, extended_data blob, primary key(key)); create index if not exists last_access_time_idx on manifest(last_access_time);";
-    return [self _dbExecute:sql];
+    if (_readOnly) {
+        // 只读附着：不建表不迁移。mmap窗口减少read()拷贝，query_only兜底拦截写入
+        return [self _dbExecute:@"pragma mmap_size = 67108864; pragma query_only = 1;"];
+    }
+    NSString *sql = @"pragma journal_mode = wal; pragma synchronous = normal; create table if not exists manifest (key text, filename text, size integer, inline_data blob, modification_time integer, last_access_time integer, extended_data blob, primary key(key)); create index if not exists last_access_time_idx on manifest(last_access_time); create table if not exists meta (key text, value integer, primary key(key));";
+    if (![self _dbExecute:sql]) return NO;
+    return [self _dbMigrate];
+}
+
+/**
+ db schema升级，已存在的数据库通过user_version增量迁移
+ */
+- (BOOL)_dbMigrate {
+    int version = 0;
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:@"pragma user_version;"];
+    if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    if (version < 1) {
+        // v1: slab日志存储需要记录value在slab文件中的偏移
+        if (![self _dbExecute:@"alter table manifest add column slab_offset integer; pragma user_version = 1;"]) return NO;
+    }
+    if (version < 2) {
+        // v2: 每条消息可以带过期时间戳
+        if (![self _dbExecute:@"alter table manifest add column expire_time integer; pragma user_version = 2;"]) return NO;
+    }
+    return YES;
 }
 
 /**
  同步WAL文件和数据库文件的行为被称为checkpoint（检查点）
  执行checkpoint之后，将sqlite-wal合并到sqlite，WAL文件会被清空
  */
+/**
+ 执行一条返回单个整数的sql（pragma等），失败返回-1
+ */
+- (int64_t)_dbGetInt64WithSql:(NSString *)sql {
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
+    if (!stmt) return -1;
+    int result = sqlite3_step(stmt);
+    if (result != SQLITE_ROW) {
+        if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite query error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+        return -1;
+    }
+    return sqlite3_column_int64(stmt, 0);
+}
+
+/**
+ meta表读取一个整数值，不存在或出错返回0
+ */
+- (int64_t)_dbGetMetaValueForKey:(NSString *)key {
+    NSString *sql = @"select value from meta where key = ?1;";
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return 0;
+    return sqlite3_column_int64(stmt, 0);
+}
+
+/**
+ meta表写入一个整数值
+ */
+- (BOOL)_dbSetMetaValue:(int64_t)value forKey:(NSString *)key {
+    NSString *sql = @"insert or replace into meta (key, value) values (?1, ?2);";
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
+    if (!stmt) return NO;
+    sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
+    sqlite3_bind_int64(stmt, 2, value);
+    int result = sqlite3_step(stmt);
+    if (result != SQLITE_DONE) {
+        if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite insert error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+        return NO;
+    }
+    return YES;
+}
+
 - (void)_dbCheckpoint {
     if (![self _dbCheck]) return;
+    NSTimeInterval opBegin = CFAbsoluteTimeGetCurrent();
+    YYKVStorageSignpostBegin("dbCheckpoint");
     // Cause a checkpoint to occur, merge `sqlite-wal` file to `sqlite` file.
     sqlite3_wal_checkpoint(_db, NULL);
+    YYKVStorageSignpostEnd("dbCheckpoint");
+    [self _recordOp:"dbCheckpoint" keyLength:0 bytes:0 begin:opBegin];
 }
 
 /**
@@ -267,31 +528,56 @@ static UIApplication *_YYSharedApplication() {
  db 保存键值对key->value
  */
 - (BOOL)_dbSaveWithKey:(NSString *)key value:(NSData *)value fileName:(NSString *)fileName extendedData:(NSData *)extendedData {
-    NSString *sql = @"insert or replace into manifest (key, filename, size, inline_data, modification_time, last_access_time, extended_data) values (?1, ?2, ?3, ?4, ?5, ?6, ?7);";
+    return [self _dbSaveWithKey:key value:value fileName:fileName extendedData:extendedData slabOffset:-1 expireTime:0];
+}
+
+/**
+ db 保存键值对key->value slabOffset为-1时表示非slab存储 expireTime为0时表示不过期
+ */
+- (BOOL)_dbSaveWithKey:(NSString *)key value:(NSData *)value fileName:(NSString *)fileName extendedData:(NSData *)extendedData slabOffset:(int64_t)slabOffset expireTime:(int)expireTime {
+    return [self _dbSaveWithKey:key value:value size:(int)value.length fileName:fileName extendedData:extendedData slabOffset:slabOffset expireTime:expireTime];
+}
+
+/**
+ db 保存键值对 size由调用方显式给出（流式落盘的文件item没有value可供取长度）
+ */
+- (BOOL)_dbSaveWithKey:(NSString *)key value:(NSData *)value size:(int)size fileName:(NSString *)fileName extendedData:(NSData *)extendedData slabOffset:(int64_t)slabOffset expireTime:(int)expireTime {
+    NSString *sql = @"insert or replace into manifest (key, filename, size, inline_data, modification_time, last_access_time, extended_data, slab_offset, expire_time) values (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9);";
     sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
     if (!stmt) return NO;
-    
+
     int timestamp = (int)time(NULL);
     sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
     sqlite3_bind_text(stmt, 2, fileName.UTF8String, -1, NULL);
     // 存储Value长度
-    sqlite3_bind_int(stmt, 3, (int)value.length);
-    if (fileName.length == 0) {
-        // 如果没有文件名，说明是存到数据库，存储字节文本
+    sqlite3_bind_int(stmt, 3, size);
+    if (fileName.length == 0 && slabOffset < 0) {
+        // 如果没有文件名也不在slab中，说明是存到数据库，存储字节文本
         sqlite3_bind_blob(stmt, 4, value.bytes, (int)value.length, 0);
     } else {
-        // 如果有文件名，存空，获取文件根据 fileName 获取
+        // 如果有文件名或存入slab，存空，读取时根据 fileName 或 slab_offset 获取
         sqlite3_bind_blob(stmt, 4, NULL, 0, 0);
     }
     sqlite3_bind_int(stmt, 5, timestamp);
     sqlite3_bind_int(stmt, 6, timestamp);
     sqlite3_bind_blob(stmt, 7, extendedData.bytes, (int)extendedData.length, 0);
+    if (slabOffset < 0) {
+        sqlite3_bind_null(stmt, 8);
+    } else {
+        sqlite3_bind_int64(stmt, 8, slabOffset);
+    }
+    sqlite3_bind_int(stmt, 9, expireTime);
     
+    NSTimeInterval opBegin = CFAbsoluteTimeGetCurrent();
+    YYKVStorageSignpostBegin("dbSave");
     int result = sqlite3_step(stmt);
+    YYKVStorageSignpostEnd("dbSave");
+    [self _recordOp:"dbSave" keyLength:key.length bytes:(NSUInteger)size begin:opBegin];
     if (result != SQLITE_DONE) {
         if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite insert error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
         return NO;
     }
+    [self _keyIndexAddKey:key];
     return YES;
 }
 
@@ -337,6 +623,54 @@ static UIApplication *_YYSharedApplication() {
     return YES;
 }
 
+/**
+ 读命中后记录一次访问 开启延迟回写时进入脏key集合，否则立即UPDATE
+ 调用方需持有_dbLock
+ */
+- (void)_noteAccessWithKey:(NSString *)key {
+    if (!_defersAccessTimeUpdates) {
+        [self _dbUpdateAccessTimeWithKey:key];
+        return;
+    }
+    [self _markAccessTimeDirtyForKeys:@[key]];
+}
+
+/**
+ 读命中后记录一组访问 开启延迟回写时进入脏key集合，否则立即UPDATE
+ 调用方需持有_dbLock
+ */
+- (void)_noteAccessWithKeys:(NSArray *)keys {
+    if (!_defersAccessTimeUpdates) {
+        [self _dbUpdateAccessTimeWithKeys:keys];
+        return;
+    }
+    [self _markAccessTimeDirtyForKeys:keys];
+}
+
+/**
+ 把keys加入脏key集合 攒满上限时就地回写
+ 调用方需持有_dbLock（回写和以前每次读取的UPDATE一样，受调用方的读排他保护）
+ 定时回写不在这里挂起：它必须和其它写入互斥，由持有写锁的YYDiskCache调度
+ */
+- (void)_markAccessTimeDirtyForKeys:(NSArray *)keys {
+    if (!_dirtyAccessKeys) _dirtyAccessKeys = [NSMutableSet new];
+    [_dirtyAccessKeys addObjectsFromArray:keys];
+    if (_dirtyAccessKeys.count >= kAccessTimeFlushMaxCount) {
+        [self _flushAccessTimeUpdatesLocked];
+    }
+}
+
+/**
+ 把积攒的访问时间在一条 UPDATE ... WHERE key IN (...) 里回写
+ 调用方需持有_dbLock
+ */
+- (void)_flushAccessTimeUpdatesLocked {
+    if (_dirtyAccessKeys.count == 0) return;
+    NSArray *keys = _dirtyAccessKeys.allObjects;
+    [_dirtyAccessKeys removeAllObjects];
+    [self _dbUpdateAccessTimeWithKeys:keys];
+}
+
 /**
  db根据key删除item
  */
@@ -351,6 +685,8 @@ static UIApplication *_YYSharedApplication() {
         if (_errorLogsEnabled) NSLog(@"%s line:%d db delete error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
         return NO;
     }
+    _dbDeletesSinceMaintenance += sqlite3_changes(_db);
+    [self _keyIndexRemoveKey:key];
     return YES;
 }
 
@@ -374,6 +710,10 @@ static UIApplication *_YYSharedApplication() {
         if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite delete error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
         return NO;
     }
+    _dbDeletesSinceMaintenance += sqlite3_changes(_db);
+    for (NSString *key in keys) {
+        [self _keyIndexRemoveKey:key];
+    }
     return YES;
 }
 
@@ -390,6 +730,8 @@ static UIApplication *_YYSharedApplication() {
         if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite delete error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
         return NO;
     }
+    _dbDeletesSinceMaintenance += sqlite3_changes(_db);
+    [self _keyIndexRebuild];
     return YES;
 }
 
@@ -406,9 +748,58 @@ static UIApplication *_YYSharedApplication() {
         if (_errorLogsEnabled)  NSLog(@"%s line:%d sqlite delete error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
         return NO;
     }
+    _dbDeletesSinceMaintenance += sqlite3_changes(_db);
+    [self _keyIndexRebuild];
+    return YES;
+}
+
+/**
+ db删除已过期的items
+ */
+- (BOOL)_dbDeleteExpiredItemsBeforeTime:(int)time {
+    NSString *sql = @"delete from manifest where expire_time > 0 and expire_time <= ?1;";
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
+    if (!stmt) return NO;
+    sqlite3_bind_int(stmt, 1, time);
+    int result = sqlite3_step(stmt);
+    if (result != SQLITE_DONE) {
+        if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite delete error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+        return NO;
+    }
+    _dbDeletesSinceMaintenance += sqlite3_changes(_db);
+    if (sqlite3_changes(_db) > 0) [self _keyIndexRebuild];
     return YES;
 }
 
+/**
+ db获取已过期items的文件名数组
+ */
+- (NSMutableArray *)_dbGetFilenamesOfExpiredItemsBeforeTime:(int)time {
+    NSString *sql = @"select filename from manifest where expire_time > 0 and expire_time <= ?1 and filename is not null;";
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
+    if (!stmt) return nil;
+    sqlite3_bind_int(stmt, 1, time);
+    
+    NSMutableArray *filenames = [NSMutableArray new];
+    do {
+        int result = sqlite3_step(stmt);
+        if (result == SQLITE_ROW) {
+            char *filename = (char *)sqlite3_column_text(stmt, 0);
+            if (filename && *filename != 0) {
+                NSString *name = [NSString stringWithUTF8String:filename];
+                if (name) [filenames addObject:name];
+            }
+        } else if (result == SQLITE_DONE) {
+            break;
+        } else {
+            if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite query error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+            filenames = nil;
+            break;
+        }
+    } while (1);
+    return filenames;
+}
+
 /**
  db根据stmt获取指定的item和拓展数据
  */
@@ -423,6 +814,9 @@ static UIApplication *_YYSharedApplication() {
     int last_access_time = sqlite3_column_int(stmt, i++);
     const void *extended_data = sqlite3_column_blob(stmt, i);
     int extended_data_bytes = sqlite3_column_bytes(stmt, i++);
+    int64_t slab_offset = sqlite3_column_type(stmt, i) == SQLITE_NULL ? -1 : sqlite3_column_int64(stmt, i);
+    i++;
+    int expire_time = sqlite3_column_int(stmt, i++);
     
     YYKVStorageItem *item = [YYKVStorageItem new];
     if (key) item.key = [NSString stringWithUTF8String:key];
@@ -432,6 +826,8 @@ static UIApplication *_YYSharedApplication() {
     item.modTime = modification_time;
     item.accessTime = last_access_time;
     if (extended_data_bytes > 0 && extended_data) item.extendedData = [NSData dataWithBytes:extended_data length:extended_data_bytes];
+    item.slabOffset = slab_offset;
+    item.expireTime = expire_time;
     return item;
 }
 
@@ -439,7 +835,7 @@ static UIApplication *_YYSharedApplication() {
  db根据key获取指定的item和拓展数据
  */
 - (YYKVStorageItem *)_dbGetItemWithKey:(NSString *)key excludeInlineData:(BOOL)excludeInlineData {
-    NSString *sql = excludeInlineData ? @"select key, filename, size, modification_time, last_access_time, extended_data from manifest where key = ?1;" : @"select key, filename, size, inline_data, modification_time, last_access_time, extended_data from manifest where key = ?1;";
+    NSString *sql = excludeInlineData ? @"select key, filename, size, modification_time, last_access_time, extended_data, slab_offset, expire_time from manifest where key = ?1;" : @"select key, filename, size, inline_data, modification_time, last_access_time, extended_data, slab_offset, expire_time from manifest where key = ?1;";
     sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
     if (!stmt) return nil;
     sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
@@ -463,9 +859,9 @@ static UIApplication *_YYSharedApplication() {
     if (![self _dbCheck]) return nil;
     NSString *sql;
     if (excludeInlineData) {
-        sql = [NSString stringWithFormat:@"select key, filename, size, modification_time, last_access_time, extended_data from manifest where key in (%@);", [self _dbJoinedKeys:keys]];
+        sql = [NSString stringWithFormat:@"select key, filename, size, modification_time, last_access_time, extended_data, slab_offset, expire_time from manifest where key in (%@);", [self _dbJoinedKeys:keys]];
     } else {
-        sql = [NSString stringWithFormat:@"select key, filename, size, inline_data, modification_time, last_access_time, extended_data from manifest where key in (%@)", [self _dbJoinedKeys:keys]];
+        sql = [NSString stringWithFormat:@"select key, filename, size, inline_data, modification_time, last_access_time, extended_data, slab_offset, expire_time from manifest where key in (%@)", [self _dbJoinedKeys:keys]];
     }
     
     sqlite3_stmt *stmt = NULL;
@@ -667,11 +1063,76 @@ static UIApplication *_YYSharedApplication() {
     return items;
 }
 
+/**
+ db获取最近访问的count条item（按last_access_time降序，跳过已过期的记录）
+ */
+- (NSMutableArray *)_dbGetItemsOrderByAccessTimeDescWithLimit:(int)count {
+    NSString *sql = @"select key, filename, size, inline_data, modification_time, last_access_time, extended_data, slab_offset, expire_time from manifest where (expire_time is null or expire_time <= 0 or expire_time > strftime('%s','now')) order by last_access_time desc limit ?1;";
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
+    if (!stmt) return nil;
+    sqlite3_bind_int(stmt, 1, count);
+    
+    NSMutableArray *items = [NSMutableArray new];
+    do {
+        int result = sqlite3_step(stmt);
+        if (result == SQLITE_ROW) {
+            YYKVStorageItem *item = [self _dbGetItemFromStmt:stmt excludeInlineData:NO];
+            if (item) [items addObject:item];
+        } else if (result == SQLITE_DONE) {
+            break;
+        } else {
+            if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite query error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+            items = nil;
+            break;
+        }
+    } while (1);
+    return items;
+}
+
+/**
+ db按last_access_time升序做一次游标扫描，边扫边累计释放的size和count，
+ 凑够目标后立即停止。一趟取回全部待删项，取代原先16条一批的反复查询。
+ */
+- (NSMutableArray *)_dbGetTrimItemsToFreeSize:(int)sizeToFree count:(int)countToFree {
+    NSString *sql = @"select key, filename, size from manifest order by last_access_time asc;";
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
+    if (!stmt) return nil;
+
+    NSMutableArray *items = [NSMutableArray new];
+    int freedSize = 0, freedCount = 0;
+    do {
+        if (freedSize >= sizeToFree && freedCount >= countToFree) break;
+        int result = sqlite3_step(stmt);
+        if (result == SQLITE_ROW) {
+            char *key = (char *)sqlite3_column_text(stmt, 0);
+            char *filename = (char *)sqlite3_column_text(stmt, 1);
+            int size = sqlite3_column_int(stmt, 2);
+            NSString *keyStr = key ? [NSString stringWithUTF8String:key] : nil;
+            if (keyStr) {
+                YYKVStorageItem *item = [YYKVStorageItem new];
+                item.key = keyStr;
+                item.filename = filename ? [NSString stringWithUTF8String:filename] : nil;
+                item.size = size;
+                [items addObject:item];
+                freedSize += size;
+                freedCount++;
+            }
+        } else if (result == SQLITE_DONE) {
+            break;
+        } else {
+            if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite query error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+            items = nil;
+            break;
+        }
+    } while (1);
+    return items;
+}
+
 /**
  db根据指定的key获取item的数量
  */
 - (int)_dbGetItemCountWithKey:(NSString *)key {
-    NSString *sql = @"select count(key) from manifest where key = ?1;";
+    NSString *sql = @"select count(key) from manifest where key = ?1 and (expire_time is null or expire_time <= 0 or expire_time > strftime('%s','now'));";
     sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
     if (!stmt) return -1;
     sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
@@ -714,29 +1175,342 @@ static UIApplication *_YYSharedApplication() {
 }
 
 
-#pragma mark - file文件读写
+#pragma mark - key索引
+
+- (void)setKeyIndexType:(YYKVStorageKeyIndexType)keyIndexType {
+    if (_keyIndexType == keyIndexType) return;
+    _keyIndexType = keyIndexType;
+    [self _keyIndexRebuild];
+}
 
 /**
- 根据文件名和文件数据写文件
+ 重建key索引：释放旧索引后从manifest全量加载key
+ 未启用时只做释放
  */
-- (BOOL)_fileWriteWithName:(NSString *)filename data:(NSData *)data {
-    NSString *path = [_dataPath stringByAppendingPathComponent:filename];
-    return [data writeToFile:path atomically:NO];
+- (void)_keyIndexRebuild {
+    if (_bloomBits) {
+        free(_bloomBits);
+        _bloomBits = NULL;
+        _bloomBitMask = 0;
+    }
+    _keySet = nil;
+    if (_keyIndexType == YYKVStorageKeyIndexTypeNone) return;
+    if (![self _dbCheck]) return;
+    
+    if (_keyIndexType == YYKVStorageKeyIndexTypeBloom) {
+        // 每个key约16位（2个哈希探测位），误判率约千分之几，向上取2的幂
+        int count = [self _dbGetTotalItemCount];
+        if (count < 0) return;
+        uint64_t bitCount = 1 << 16;
+        while (bitCount < (uint64_t)count * 16) bitCount <<= 1;
+        _bloomBits = calloc(bitCount / 64, sizeof(uint64_t));
+        if (!_bloomBits) return;
+        _bloomBitMask = bitCount - 1;
+    } else {
+        _keySet = [NSMutableSet new];
+    }
+    
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:@"select key from manifest;"];
+    if (!stmt) return;
+    do {
+        int result = sqlite3_step(stmt);
+        if (result == SQLITE_ROW) {
+            char *key = (char *)sqlite3_column_text(stmt, 0);
+            if (key) [self _keyIndexAddKey:[NSString stringWithUTF8String:key]];
+        } else if (result == SQLITE_DONE) {
+            break;
+        } else {
+            if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite query error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+            break;
+        }
+    } while (1);
 }
 
 /**
- 根据文件名读取文件数据
+ 把key加入索引
  */
-- (NSData *)_fileReadWithName:(NSString *)filename {
-    NSString *path = [_dataPath stringByAppendingPathComponent:filename];
-    NSData *data = [NSData dataWithContentsOfFile:path];
-    return data;
+- (void)_keyIndexAddKey:(NSString *)key {
+    if (_bloomBits) {
+        uint64_t hash = _YYKeyIndexHash(key);
+        uint64_t bit0 = hash & _bloomBitMask;
+        uint64_t bit1 = (hash >> 32) & _bloomBitMask;
+        _bloomBits[bit0 / 64] |= 1UL << (bit0 % 64);
+        _bloomBits[bit1 / 64] |= 1UL << (bit1 % 64);
+    } else if (_keySet) {
+        [_keySet addObject:key];
+    }
 }
 
 /**
- 根据文件名删除文件
+ 把key移出索引
+ bloom不支持删除（保持超集仍然正确，死位由重建回收），只有精确集合会删除
  */
-- (BOOL)_fileDeleteWithName:(NSString *)filename {
+- (void)_keyIndexRemoveKey:(NSString *)key {
+    if (_keySet) [_keySet removeObject:key];
+}
+
+/**
+ key是否可能在存储中，返回NO时一定不存在
+ 未启用索引时总是返回YES
+ */
+- (BOOL)_keyIndexMayContainKey:(NSString *)key {
+    if (_bloomBits) {
+        uint64_t hash = _YYKeyIndexHash(key);
+        uint64_t bit0 = hash & _bloomBitMask;
+        uint64_t bit1 = (hash >> 32) & _bloomBitMask;
+        return (_bloomBits[bit0 / 64] & (1UL << (bit0 % 64)))
+            && (_bloomBits[bit1 / 64] & (1UL << (bit1 % 64)));
+    } else if (_keySet) {
+        return [_keySet containsObject:key];
+    }
+    return YES;
+}
+
+
+#pragma mark - slab日志文件读写
+
+/**
+ 打开（或创建）slab日志文件，记录末尾偏移
+ */
+- (BOOL)_slabOpen {
+    if (_slabFD >= 0) return YES;
+    // 惰性打开可能被多个并发的首次读取同时触发，check-then-act要加锁
+    // 否则两个线程都open()一次（泄漏fd）并竞争_slabEnd的写入
+    pthread_mutex_lock(&_slabOpenLock);
+    if (_slabFD >= 0) {
+        pthread_mutex_unlock(&_slabOpenLock);
+        return YES;
+    }
+    NSString *path = [_dataPath stringByAppendingPathComponent:kSlabFileName];
+    int fd = open(path.UTF8String, _readOnly ? O_RDONLY : (O_RDWR | O_CREAT), 0644);
+    if (fd < 0) {
+        if (_errorLogsEnabled) NSLog(@"%s line:%d slab open failed (%d).", __FUNCTION__, __LINE__, errno);
+        pthread_mutex_unlock(&_slabOpenLock);
+        return NO;
+    }
+    int64_t end = lseek(fd, 0, SEEK_END);
+    if (end < 0) {
+        close(fd);
+        pthread_mutex_unlock(&_slabOpenLock);
+        return NO;
+    }
+    _slabEnd = end;
+    _slabFD = fd; // fd最后发布，别的线程看到有效fd时末尾偏移已经就绪
+    pthread_mutex_unlock(&_slabOpenLock);
+    return YES;
+}
+
+/**
+ 关闭slab日志文件
+ */
+- (void)_slabClose {
+    if (_slabFD >= 0) {
+        close(_slabFD);
+        _slabFD = -1;
+        _slabEnd = 0;
+    }
+}
+
+/**
+ 将value追加到slab日志文件末尾，返回偏移，失败返回-1
+ */
+- (int64_t)_slabAppendValue:(NSData *)value {
+    if (![self _slabOpen]) return -1;
+    int64_t offset = _slabEnd;
+    NSTimeInterval opBegin = CFAbsoluteTimeGetCurrent();
+    YYKVStorageSignpostBegin("slabAppend");
+    ssize_t written = pwrite(_slabFD, value.bytes, value.length, offset);
+    YYKVStorageSignpostEnd("slabAppend");
+    [self _recordOp:"slabAppend" keyLength:0 bytes:value.length begin:opBegin];
+    if (written != (ssize_t)value.length) {
+        if (_errorLogsEnabled) NSLog(@"%s line:%d slab write failed (%d).", __FUNCTION__, __LINE__, errno);
+        if (written > 0) ftruncate(_slabFD, offset); // 回滚部分写入
+        return -1;
+    }
+    _slabEnd = offset + written;
+    return offset;
+}
+
+/**
+ 从slab日志文件的指定偏移读取value
+ */
+- (NSData *)_slabReadValueAtOffset:(int64_t)offset size:(int)size {
+    if (offset < 0 || size <= 0) return nil;
+    if (![self _slabOpen]) return nil;
+    NSMutableData *data = [NSMutableData dataWithLength:size];
+    NSTimeInterval opBegin = CFAbsoluteTimeGetCurrent();
+    YYKVStorageSignpostBegin("slabRead");
+    ssize_t readBytes = pread(_slabFD, data.mutableBytes, size, offset);
+    YYKVStorageSignpostEnd("slabRead");
+    [self _recordOp:"slabRead" keyLength:0 bytes:size begin:opBegin];
+    if (readBytes != size) {
+        if (_errorLogsEnabled) NSLog(@"%s line:%d slab read failed (%d).", __FUNCTION__, __LINE__, errno);
+        return nil;
+    }
+    return data;
+}
+
+/**
+ db获取slab中存活value的总大小
+ */
+- (int64_t)_dbGetSlabItemsSize {
+    NSString *sql = @"select sum(size) from manifest where slab_offset is not null;";
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:sql];
+    if (!stmt) return -1;
+    int result = sqlite3_step(stmt);
+    if (result != SQLITE_ROW) {
+        if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite query error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+        return -1;
+    }
+    return sqlite3_column_int64(stmt, 0);
+}
+
+/**
+ 死空间超过阈值并过半时压缩slab日志文件
+ */
+- (void)_slabCompactIfNeeded {
+    // 事务里不能压缩：嵌套的begin会失败，偏移改写跟着外层事务走，
+    // 而slab换文件不会随外层rollback恢复，提交/回滚后偏移和文件必然对不上
+    // 批量保存时先记下来，等外层事务结束后再做
+    if (_db && !sqlite3_get_autocommit(_db)) {
+        _slabCompactionPending = YES;
+        return;
+    }
+    if (![self _slabOpen]) return;
+    int64_t live = [self _dbGetSlabItemsSize];
+    if (live < 0) return;
+    int64_t dead = _slabEnd - live;
+    if (dead < kSlabCompactionMinDeadBytes || dead * 2 < _slabEnd) return;
+    [self _slabCompact];
+}
+
+/**
+ 压缩slab：存活的value顺序拷贝进新文件，manifest在一个事务中改写偏移
+ 旧文件进入回收站由后台清空
+ */
+- (BOOL)_slabCompact {
+    if (![self _dbCheck] || ![self _slabOpen]) return NO;
+    
+    // 收集存活条目，避免边扫描边改写同一张表
+    NSMutableArray *items = [NSMutableArray new];
+    sqlite3_stmt *stmt = [self _dbPrepareStmt:@"select key, size, slab_offset from manifest where slab_offset is not null order by slab_offset asc;"];
+    if (!stmt) return NO;
+    do {
+        int result = sqlite3_step(stmt);
+        if (result == SQLITE_ROW) {
+            char *key = (char *)sqlite3_column_text(stmt, 0);
+            if (!key) continue;
+            YYKVStorageItem *item = [YYKVStorageItem new];
+            item.key = [NSString stringWithUTF8String:key];
+            item.size = sqlite3_column_int(stmt, 1);
+            item.slabOffset = sqlite3_column_int64(stmt, 2);
+            [items addObject:item];
+        } else if (result == SQLITE_DONE) {
+            break;
+        } else {
+            if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite query error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+            return NO;
+        }
+    } while (1);
+    
+    NSString *tmpPath = [_dataPath stringByAppendingPathComponent:kSlabTmpFileName];
+    int newFD = open(tmpPath.UTF8String, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (newFD < 0) return NO;
+    
+    // 偏移改写必须真的在自己的事务里：失败时整体回滚，和下面的换文件才是原子的
+    if (![self _dbExecute:@"begin immediate;"]) {
+        close(newFD);
+        unlink(tmpPath.UTF8String);
+        return NO;
+    }
+    BOOL suc = YES;
+    int64_t newEnd = 0;
+    for (YYKVStorageItem *item in items) {
+        NSData *value = [self _slabReadValueAtOffset:item.slabOffset size:item.size];
+        if (!value || pwrite(newFD, value.bytes, value.length, newEnd) != (ssize_t)value.length) {
+            suc = NO;
+            break;
+        }
+        sqlite3_stmt *update = [self _dbPrepareStmt:@"update manifest set slab_offset = ?1 where key = ?2;"];
+        if (!update) {
+            suc = NO;
+            break;
+        }
+        sqlite3_bind_int64(update, 1, newEnd);
+        sqlite3_bind_text(update, 2, item.key.UTF8String, -1, NULL);
+        if (sqlite3_step(update) != SQLITE_DONE) {
+            suc = NO;
+            break;
+        }
+        newEnd += item.size;
+    }
+    if (!suc) {
+        [self _dbExecute:@"rollback;"];
+        close(newFD);
+        unlink(tmpPath.UTF8String);
+        return NO;
+    }
+    if (![self _dbExecute:@"commit;"]) {
+        [self _dbExecute:@"rollback;"];
+        close(newFD);
+        unlink(tmpPath.UTF8String);
+        return NO;
+    }
+    
+    // 旧slab移入回收站，新slab原地改名
+    [self _slabClose];
+    CFUUIDRef uuidRef = CFUUIDCreate(NULL);
+    CFStringRef uuid = CFUUIDCreateString(NULL, uuidRef);
+    CFRelease(uuidRef);
+    NSString *trashPath = [_trashPath stringByAppendingPathComponent:(__bridge NSString *)(uuid)];
+    CFRelease(uuid);
+    NSString *slabPath = [_dataPath stringByAppendingPathComponent:kSlabFileName];
+    [[NSFileManager defaultManager] moveItemAtPath:slabPath toPath:trashPath error:NULL];
+    close(newFD);
+    [[NSFileManager defaultManager] moveItemAtPath:tmpPath toPath:slabPath error:NULL];
+    [self _fileEmptyTrashInBackground];
+    return [self _slabOpen];
+}
+
+
+#pragma mark - file文件读写
+
+/**
+ 根据文件名和文件数据写文件
+ */
+- (BOOL)_fileWriteWithName:(NSString *)filename data:(NSData *)data {
+    NSString *path = [_dataPath stringByAppendingPathComponent:filename];
+    NSTimeInterval opBegin = CFAbsoluteTimeGetCurrent();
+    YYKVStorageSignpostBegin("fileWrite");
+    BOOL suc = [data writeToFile:path atomically:NO];
+    YYKVStorageSignpostEnd("fileWrite");
+    [self _recordOp:"fileWrite" keyLength:0 bytes:data.length begin:opBegin];
+    return suc;
+}
+
+/**
+ 根据文件名读取文件数据
+ */
+- (NSData *)_fileReadWithName:(NSString *)filename {
+    NSString *path = [_dataPath stringByAppendingPathComponent:filename];
+    NSTimeInterval opBegin = CFAbsoluteTimeGetCurrent();
+    YYKVStorageSignpostBegin("fileRead");
+    NSData *data = nil;
+    if (_mappedReadEnabled) {
+        // mmap映射读取，内容按需换页，不在匿名内存中再复制一份
+        // 注意：文件被unlink后已建立的映射依然有效，删除item不会影响在途的value
+        data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:NULL];
+    }
+    if (!data) data = [NSData dataWithContentsOfFile:path];
+    YYKVStorageSignpostEnd("fileRead");
+    [self _recordOp:"fileRead" keyLength:0 bytes:data.length begin:opBegin];
+    return data;
+}
+
+/**
+ 根据文件名删除文件
+ */
+- (BOOL)_fileDeleteWithName:(NSString *)filename {
     NSString *path = [_dataPath stringByAppendingPathComponent:filename];
     return [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
 }
@@ -783,6 +1557,7 @@ static UIApplication *_YYSharedApplication() {
  删除所有的文件并在后台清空 确保db为关闭状态
  */
 - (void)_reset {
+    [self _slabClose];
     [[NSFileManager defaultManager] removeItemAtPath:[_path stringByAppendingPathComponent:kDBFileName] error:nil];
     [[NSFileManager defaultManager] removeItemAtPath:[_path stringByAppendingPathComponent:kDBShmFileName] error:nil];
     [[NSFileManager defaultManager] removeItemAtPath:[_path stringByAppendingPathComponent:kDBWalFileName] error:nil];
@@ -798,23 +1573,45 @@ static UIApplication *_YYSharedApplication() {
 }
 
 - (instancetype)initWithPath:(NSString *)path type:(YYKVStorageType)type {
+    return [self initWithPath:path type:type readOnly:NO];
+}
+
+- (instancetype)initWithPath:(NSString *)path type:(YYKVStorageType)type readOnly:(BOOL)readOnly {
     if (path.length == 0 || path.length > kPathLengthMax) {
         NSLog(@"YYKVStorage init error: invalid path: [%@].", path);
         return nil;
     }
-    if (type > YYKVStorageTypeMixed) {
+    if (type > YYKVStorageTypeSlab) {
         NSLog(@"YYKVStorage init error: invalid type: %lu.", (unsigned long)type);
         return nil;
     }
-    
+
     self = [super init];
     _path = path.copy;
     _type = type;
+    _readOnly = readOnly;
+    _slabFD = -1;
+    pthread_mutex_init(&_dbLock, NULL);
+    pthread_mutex_init(&_slabOpenLock, NULL);
+    pthread_mutex_init(&_slowOpLock, NULL);
+    _slowOps = calloc(kSlowOpRingCapacity, sizeof(_YYKVStorageSlowOpRecord));
+    pthread_mutex_init(&_ioProfileLock, NULL);
+    _ioProfile = calloc(kIOProfileBucketCount, sizeof(_YYKVStorageIOProfileBucket));
     _dataPath = [path stringByAppendingPathComponent:kDataDirectoryName];
     _trashPath = [path stringByAppendingPathComponent:kTrashDirectoryName];
     _trashQueue = dispatch_queue_create("com.ibireme.cache.disk.trash", DISPATCH_QUEUE_SERIAL);
     _dbPath = [path stringByAppendingPathComponent:kDBFileName];
     _errorLogsEnabled = YES;
+    if (readOnly) {
+        // 只读附着：不创建目录、不修库，打不开就直接失败
+        if (![self _dbOpen] || ![self _dbInitialize]) {
+            [self _dbClose];
+            NSLog(@"YYKVStorage init error: fail to open sqlite db read-only.");
+            return nil;
+        }
+        _learnedInlineThreshold = (NSUInteger)[self _dbGetMetaValueForKey:kMetaKeyInlineThreshold];
+        return self;
+    }
     NSError *error = nil;
     if (![[NSFileManager defaultManager] createDirectoryAtPath:path
                                    withIntermediateDirectories:YES
@@ -842,6 +1639,7 @@ static UIApplication *_YYSharedApplication() {
             return nil;
         }
     }
+    _learnedInlineThreshold = (NSUInteger)[self _dbGetMetaValueForKey:kMetaKeyInlineThreshold];
     [self _fileEmptyTrashInBackground]; // empty the trash if failed at last time
     return self;
 }
@@ -852,7 +1650,16 @@ static UIApplication *_YYSharedApplication() {
 - (void)dealloc {
     // 销毁时，application 开启一个后台处理任务，等待 DB close
     UIBackgroundTaskIdentifier taskID = [_YYSharedApplication() beginBackgroundTaskWithExpirationHandler:^{}];
+    [self flushAccessTimeUpdates];
     [self _dbClose];
+    [self _slabClose];
+    if (_bloomBits) free(_bloomBits);
+    if (_slowOps) free(_slowOps);
+    if (_ioProfile) free(_ioProfile);
+    pthread_mutex_destroy(&_dbLock);
+    pthread_mutex_destroy(&_slabOpenLock);
+    pthread_mutex_destroy(&_slowOpLock);
+    pthread_mutex_destroy(&_ioProfileLock);
     // DB 关闭完成后，结束后台任务
     if (taskID != UIBackgroundTaskInvalid) {
         [_YYSharedApplication() endBackgroundTask:taskID];
@@ -865,7 +1672,7 @@ static UIApplication *_YYSharedApplication() {
  保存item key值存在时更新item
  */
 - (BOOL)saveItem:(YYKVStorageItem *)item {
-    return [self saveItemWithKey:item.key value:item.value filename:item.filename extendedData:item.extendedData];
+    return [self saveItemWithKey:item.key value:item.value filename:item.filename extendedData:item.extendedData expireTime:item.expireTime];
 }
 
 /**
@@ -879,6 +1686,14 @@ static UIApplication *_YYSharedApplication() {
  保存item key值存在时更新item
  */
 - (BOOL)saveItemWithKey:(NSString *)key value:(NSData *)value filename:(NSString *)filename extendedData:(NSData *)extendedData {
+    return [self saveItemWithKey:key value:value filename:filename extendedData:extendedData expireTime:0];
+}
+
+/**
+ 保存item key值存在时更新item expireTime为0时表示不过期
+ */
+- (BOOL)saveItemWithKey:(NSString *)key value:(NSData *)value filename:(NSString *)filename extendedData:(NSData *)extendedData expireTime:(int)expireTime {
+    if (_readOnly) return NO;
     // 没有 Key，也没有 Value 直接返回 NO
     if (key.length == 0 || value.length == 0) return NO;
     // 存文件，但是没有文件名，也直接返回 NO
@@ -892,12 +1707,28 @@ static UIApplication *_YYSharedApplication() {
             return NO;
         }
         // 将文件名写入数据库，之后方便根据 Key 去查找文件
-        if (![self _dbSaveWithKey:key value:value fileName:filename extendedData:extendedData]) {
+        if (![self _dbSaveWithKey:key value:value fileName:filename extendedData:extendedData slabOffset:-1 expireTime:expireTime]) {
             // 如果写入数据库失败，把之前写入的文件删除
             [self _fileDeleteWithName:filename];
             return NO;
         }
         return YES;
+    } else if (_type == YYKVStorageTypeSlab) {
+        // 小value追加进slab日志文件，manifest记录偏移；旧的文件类型value需要清理
+        NSString *oldFilename = [self _dbGetFilenameWithKey:key];
+        if (oldFilename) {
+            [self _fileDeleteWithName:oldFilename];
+        }
+        int64_t offset = [self _slabAppendValue:value];
+        if (offset < 0) return NO;
+        if (![self _dbSaveWithKey:key value:value fileName:nil extendedData:extendedData slabOffset:offset expireTime:expireTime]) {
+            return NO;
+        }
+        if (++_slabOpsSinceCompactionCheck >= kSlabCompactionCheckInterval) {
+            _slabOpsSinceCompactionCheck = 0;
+            [self _slabCompactIfNeeded];
+        }
+        return YES;
     } else {
         if (_type != YYKVStorageTypeSQLite) {
             NSString *filename = [self _dbGetFilenameWithKey:key];
@@ -905,23 +1736,101 @@ static UIApplication *_YYSharedApplication() {
                 [self _fileDeleteWithName:filename];
             }
         }
-        return [self _dbSaveWithKey:key value:value fileName:nil extendedData:extendedData];
+        return [self _dbSaveWithKey:key value:value fileName:nil extendedData:extendedData slabOffset:-1 expireTime:expireTime];
     }
 }
 
+/**
+ 从文件URL流式保存item key值存在时更新item
+ */
+- (BOOL)saveItemWithKey:(NSString *)key fromFileURL:(NSURL *)fileURL filename:(NSString *)filename extendedData:(NSData *)extendedData {
+    return [self saveItemWithKey:key fromFileURL:fileURL filename:filename extendedData:extendedData expireTime:0];
+}
+
+/**
+ 从文件URL流式保存item，payload不经过堆内存 key值存在时更新item expireTime为0时表示不过期
+ */
+- (BOOL)saveItemWithKey:(NSString *)key fromFileURL:(NSURL *)fileURL filename:(NSString *)filename extendedData:(NSData *)extendedData expireTime:(int)expireTime {
+    if (_readOnly) return NO;
+    if (key.length == 0 || filename.length == 0) return NO;
+    if (!fileURL.isFileURL) return NO;
+    // sqlite类型没有data目录，放不下文件
+    if (_type == YYKVStorageTypeSQLite) return NO;
+
+    NSString *srcPath = fileURL.path;
+    NSNumber *fileSize = [[[NSFileManager defaultManager] attributesOfItemAtPath:srcPath error:NULL] objectForKey:NSFileSize];
+    if (!fileSize || fileSize.longLongValue <= 0 || fileSize.longLongValue > INT_MAX) return NO;
+
+    // key原先的value可能落在别的文件里，保存成功后要清理；slab里的旧value留给压实回收
+    NSString *oldFilename = [self _dbGetFilenameWithKey:key];
+
+    NSString *dstPath = [_dataPath stringByAppendingPathComponent:filename];
+    [[NSFileManager defaultManager] removeItemAtPath:dstPath error:NULL];
+    NSTimeInterval opBegin = CFAbsoluteTimeGetCurrent();
+    YYKVStorageSignpostBegin("fileLink");
+    // 同卷时硬链接是零拷贝零额外空间，跨卷退化成一次文件复制，两条路payload都不经过堆
+    BOOL suc = (link(srcPath.UTF8String, dstPath.UTF8String) == 0);
+    if (!suc) {
+        suc = [[NSFileManager defaultManager] copyItemAtPath:srcPath toPath:dstPath error:NULL];
+    }
+    YYKVStorageSignpostEnd("fileLink");
+    [self _recordOp:"fileLink" keyLength:key.length bytes:(NSUInteger)fileSize.longLongValue begin:opBegin];
+    if (!suc) return NO;
+
+    if (![self _dbSaveWithKey:key value:nil size:(int)fileSize.longLongValue fileName:filename extendedData:extendedData slabOffset:-1 expireTime:expireTime]) {
+        // 如果写入数据库失败，把刚链接/复制进来的文件删除
+        [self _fileDeleteWithName:filename];
+        return NO;
+    }
+    if (oldFilename && ![oldFilename isEqualToString:filename]) {
+        [self _fileDeleteWithName:oldFilename];
+    }
+    return YES;
+}
+
+/**
+ 在一个事务中批量保存items，避免每条insert单独提交WAL
+ */
+- (BOOL)saveItems:(NSArray<YYKVStorageItem *> *)items {
+    if (items.count == 0) return NO;
+    if (items.count == 1) return [self saveItem:items.firstObject];
+    if (![self _dbCheck]) return NO;
+
+    // 事务开启失败时退回逐条自动提交
+    BOOL inTransaction = [self _dbExecute:@"begin immediate;"];
+    BOOL suc = YES;
+    for (YYKVStorageItem *item in items) {
+        if (![self saveItem:item]) suc = NO;
+    }
+    if (inTransaction) {
+        if (![self _dbExecute:@"commit;"]) {
+            [self _dbExecute:@"rollback;"];
+            suc = NO;
+        }
+    }
+    if (_slabCompactionPending) {
+        _slabCompactionPending = NO;
+        [self _slabCompactIfNeeded];
+    }
+    return suc;
+}
+
 #pragma mark - 删除消息
 
 /**
  根据key值删除item
  */
 - (BOOL)removeItemForKey:(NSString *)key {
+    if (_readOnly) return NO;
     if (key.length == 0) return NO;
     switch (_type) {
         case YYKVStorageTypeSQLite: {
             return [self _dbDeleteItemWithKey:key];
         } break;
         case YYKVStorageTypeFile:
-        case YYKVStorageTypeMixed: {
+        case YYKVStorageTypeMixed:
+        case YYKVStorageTypeSlab: {
+            // slab中的value随行删除变成死空间，由后台压缩回收
             NSString *filename = [self _dbGetFilenameWithKey:key];
             if (filename) {
                 [self _fileDeleteWithName:filename];
@@ -936,13 +1845,15 @@ static UIApplication *_YYSharedApplication() {
  根据keys数组删除items
  */
 - (BOOL)removeItemForKeys:(NSArray *)keys {
+    if (_readOnly) return NO;
     if (keys.count == 0) return NO;
     switch (_type) {
         case YYKVStorageTypeSQLite: {
             return [self _dbDeleteItemWithKeys:keys];
         } break;
         case YYKVStorageTypeFile:
-        case YYKVStorageTypeMixed: {
+        case YYKVStorageTypeMixed:
+        case YYKVStorageTypeSlab: {
             NSArray *filenames = [self _dbGetFilenameWithKeys:keys];
             for (NSString *filename in filenames) {
                 [self _fileDeleteWithName:filename];
@@ -957,6 +1868,7 @@ static UIApplication *_YYSharedApplication() {
  根据消息value的开销限制删除items
  */
 - (BOOL)removeItemsLargerThanSize:(int)size {
+    if (_readOnly) return NO;
     if (size == INT_MAX) return YES;
     if (size <= 0) return [self removeAllItems];
     
@@ -968,7 +1880,8 @@ static UIApplication *_YYSharedApplication() {
             }
         } break;
         case YYKVStorageTypeFile:
-        case YYKVStorageTypeMixed: {
+        case YYKVStorageTypeMixed:
+        case YYKVStorageTypeSlab: {
             NSArray *filenames = [self _dbGetFilenamesWithSizeLargerThan:size];
             for (NSString *name in filenames) {
                 [self _fileDeleteWithName:name];
@@ -986,6 +1899,7 @@ static UIApplication *_YYSharedApplication() {
  删除比指定时间更早存入的消息
  */
 - (BOOL)removeItemsEarlierThanTime:(int)time {
+    if (_readOnly) return NO;
     if (time <= 0) return YES;
     if (time == INT_MAX) return [self removeAllItems];
     
@@ -997,7 +1911,8 @@ static UIApplication *_YYSharedApplication() {
             }
         } break;
         case YYKVStorageTypeFile:
-        case YYKVStorageTypeMixed: {
+        case YYKVStorageTypeMixed:
+        case YYKVStorageTypeSlab: {
             NSArray *filenames = [self _dbGetFilenamesWithTimeEarlierThan:time];
             for (NSString *name in filenames) {
                 [self _fileDeleteWithName:name];
@@ -1011,83 +1926,104 @@ static UIApplication *_YYSharedApplication() {
     return NO;
 }
 
+/**
+ 删除一批待裁剪的item：先删文件，再把key分块拼成in语句批量删manifest记录
+ */
+- (BOOL)_removeTrimItems:(NSArray *)items {
+    if (items.count == 0) return YES;
+    NSMutableArray *keys = [NSMutableArray new];
+    for (YYKVStorageItem *item in items) {
+        if (item.filename) {
+            [self _fileDeleteWithName:item.filename];
+        }
+        [keys addObject:item.key];
+    }
+    // 分块避免in列表超出sqlite的绑定参数上限
+    const NSUInteger perCount = 128;
+    for (NSUInteger i = 0; i < keys.count; i += perCount) {
+        NSRange range = NSMakeRange(i, MIN(perCount, keys.count - i));
+        if (![self _dbDeleteItemWithKeys:[keys subarrayWithRange:range]]) return NO;
+    }
+    return YES;
+}
+
 /**
  根据消息开销限制删除items (LRU对象优先删除)
  */
 - (BOOL)removeItemsToFitSize:(int)maxSize {
+    if (_readOnly) return NO;
     if (maxSize == INT_MAX) return YES;
     if (maxSize <= 0) return [self removeAllItems];
-    
+
+    // 先把积攒的访问时间落库，修剪顺序才能反映最近的读取
+    [self flushAccessTimeUpdates];
+
     int total = [self _dbGetTotalItemSize];
     if (total < 0) return NO;
     if (total <= maxSize) return YES;
-    
-    NSArray *items = nil;
-    BOOL suc = NO;
-    do {
-        int perCount = 16;
-        items = [self _dbGetItemSizeInfoOrderByTimeAscWithLimit:perCount];
-        for (YYKVStorageItem *item in items) {
-            if (total > maxSize) {
-                if (item.filename) {
-                    [self _fileDeleteWithName:item.filename];
-                }
-                suc = [self _dbDeleteItemWithKey:item.key];
-                total -= item.size;
-            } else {
-                break;
-            }
-            if (!suc) break;
-        }
-    } while (total > maxSize && items.count > 0 && suc);
-    if (suc) [self _dbCheckpoint];
-    return suc;
+
+    NSArray *items = [self _dbGetTrimItemsToFreeSize:total - maxSize count:0];
+    if (!items) return NO;
+    if (![self _removeTrimItems:items]) return NO;
+    [self _dbCheckpoint];
+    return YES;
 }
 
 /**
  根据消息数量限制删除items (LRU对象优先删除)
  */
 - (BOOL)removeItemsToFitCount:(int)maxCount {
+    if (_readOnly) return NO;
     if (maxCount == INT_MAX) return YES;
     if (maxCount <= 0) return [self removeAllItems];
-    
+
+    // 先把积攒的访问时间落库，修剪顺序才能反映最近的读取
+    [self flushAccessTimeUpdates];
+
     int total = [self _dbGetTotalItemCount];
     if (total < 0) return NO;
     if (total <= maxCount) return YES;
-    
-    NSArray *items = nil;
-    BOOL suc = NO;
-    do {
-        int perCount = 16;
-        items = [self _dbGetItemSizeInfoOrderByTimeAscWithLimit:perCount];
-        for (YYKVStorageItem *item in items) {
-            if (total > maxCount) {
-                if (item.filename) {
-                    [self _fileDeleteWithName:item.filename];
-                }
-                suc = [self _dbDeleteItemWithKey:item.key];
-                total--;
-            } else {
-                break;
-            }
-            if (!suc) break;
-        }
-    } while (total > maxCount && items.count > 0 && suc);
-    if (suc) [self _dbCheckpoint];
-    return suc;
+
+    NSArray *items = [self _dbGetTrimItemsToFreeSize:0 count:total - maxCount];
+    if (!items) return NO;
+    if (![self _removeTrimItems:items]) return NO;
+    [self _dbCheckpoint];
+    return YES;
+}
+
+/**
+ 删除所有已过期的items（惰性回收：读取时过期只当作未命中，真正的删除在这里进行）
+ */
+- (BOOL)removeExpiredItems {
+    if (_readOnly) return NO;
+    int timestamp = (int)time(NULL);
+    NSArray *filenames = [self _dbGetFilenamesOfExpiredItemsBeforeTime:timestamp];
+    for (NSString *filename in filenames) {
+        [self _fileDeleteWithName:filename];
+    }
+    if ([self _dbDeleteExpiredItemsBeforeTime:timestamp]) {
+        [self _dbCheckpoint];
+        return YES;
+    }
+    return NO;
 }
 
 - (BOOL)removeAllItems {
+    if (_readOnly) return NO;
     if (![self _dbClose]) return NO;
     [self _reset];
     if (![self _dbOpen]) return NO;
     if (![self _dbInitialize]) return NO;
+    [self _keyIndexRebuild];
     return YES;
 }
 
 - (void)removeAllItemsWithProgressBlock:(void(^)(int removedCount, int totalCount))progress
                                endBlock:(void(^)(BOOL error))end {
-    
+    if (_readOnly) {
+        if (end) end(YES);
+        return;
+    }
     int total = [self _dbGetTotalItemCount];
     if (total <= 0) {
         if (end) end(total < 0);
@@ -1119,88 +2055,276 @@ static UIApplication *_YYSharedApplication() {
 
 - (YYKVStorageItem *)getItemForKey:(NSString *)key {
     if (key.length == 0) return nil;
-    YYKVStorageItem *item = [self _dbGetItemWithKey:key excludeInlineData:NO];
+    pthread_mutex_lock(&_dbLock);
+    YYKVStorageItem *item = nil;
+    NSString *expiredFilename = nil;
+    NSTimeInterval fetchDuration = 0;
+    if ([self _keyIndexMayContainKey:key]) {
+        NSTimeInterval fetchBegin = CFAbsoluteTimeGetCurrent();
+        item = [self _dbGetItemWithKey:key excludeInlineData:NO];
+        fetchDuration = CFAbsoluteTimeGetCurrent() - fetchBegin;
+        if (item && item.expireTime > 0 && item.expireTime <= (int)time(NULL)) {
+            // 过期视作未命中，顺手删除记录（只读模式留给持有写实例的进程回收）
+            if (!_readOnly) {
+                [self _dbDeleteItemWithKey:key];
+                expiredFilename = item.filename;
+            }
+            item = nil;
+        }
+        if (item && !_readOnly) [self _noteAccessWithKey:key];
+    }
+    pthread_mutex_unlock(&_dbLock);
+    if (expiredFilename) [self _fileDeleteWithName:expiredFilename];
     if (item) {
-        [self _dbUpdateAccessTimeWithKey:key];
+        // 文件和slab的读取在db锁外进行，并发读取时互不阻塞
         if (item.filename) {
+            NSTimeInterval readBegin = CFAbsoluteTimeGetCurrent();
             item.value = [self _fileReadWithName:item.filename];
-            if (!item.value) {
+            // 文件读的耗时记入画像，和inline blob读对比学习阈值
+            if (item.value) [self _ioProfileRecordReadWithSize:item.size duration:CFAbsoluteTimeGetCurrent() - readBegin fromFile:YES];
+        } else if (item.slabOffset >= 0 && !item.value) {
+            item.value = [self _slabReadValueAtOffset:item.slabOffset size:item.size];
+        } else if (item.value) {
+            // inline blob的读取耗时就是取行的耗时（blob随行一起取回）
+            [self _ioProfileRecordReadWithSize:item.size duration:fetchDuration fromFile:NO];
+        }
+        if (!item.value) {
+            if (!_readOnly) {
+                pthread_mutex_lock(&_dbLock);
                 [self _dbDeleteItemWithKey:key];
-                item = nil;
+                pthread_mutex_unlock(&_dbLock);
             }
+            item = nil;
         }
     }
     return item;
 }
 
+- (NSURL *)getItemFileURLForKey:(NSString *)key {
+    if (key.length == 0) return nil;
+    pthread_mutex_lock(&_dbLock);
+    NSString *filename = nil;
+    if ([self _keyIndexMayContainKey:key]) {
+        YYKVStorageItem *item = [self _dbGetItemWithKey:key excludeInlineData:YES];
+        // 过期视作未命中，记录留给removeExpiredItems回收
+        if (item && !(item.expireTime > 0 && item.expireTime <= (int)time(NULL))) {
+            filename = item.filename;
+            if (filename && !_readOnly) [self _noteAccessWithKey:key];
+        }
+    }
+    pthread_mutex_unlock(&_dbLock);
+    if (!filename) return nil;
+    NSString *path = [_dataPath stringByAppendingPathComponent:filename];
+    if (![[NSFileManager defaultManager] fileExistsAtPath:path]) return nil;
+    return [NSURL fileURLWithPath:path isDirectory:NO];
+}
+
 - (YYKVStorageItem *)getItemInfoForKey:(NSString *)key {
     if (key.length == 0) return nil;
-    YYKVStorageItem *item = [self _dbGetItemWithKey:key excludeInlineData:YES];
+    pthread_mutex_lock(&_dbLock);
+    YYKVStorageItem *item = nil;
+    if ([self _keyIndexMayContainKey:key]) {
+        item = [self _dbGetItemWithKey:key excludeInlineData:YES];
+        if (item && item.expireTime > 0 && item.expireTime <= (int)time(NULL)) item = nil;
+    }
+    pthread_mutex_unlock(&_dbLock);
     return item;
 }
 
 - (NSData *)getItemValueForKey:(NSString *)key {
     if (key.length == 0) return nil;
+    pthread_mutex_lock(&_dbLock);
+    if (![self _keyIndexMayContainKey:key]) {
+        pthread_mutex_unlock(&_dbLock);
+        return nil;
+    }
     NSData *value = nil;
-    switch (_type) {
-        case YYKVStorageTypeFile: {
-            NSString *filename = [self _dbGetFilenameWithKey:key];
-            if (filename) {
-                value = [self _fileReadWithName:filename];
-                if (!value) {
-                    [self _dbDeleteItemWithKey:key];
-                    value = nil;
-                }
-            }
-        } break;
-        case YYKVStorageTypeSQLite: {
-            value = [self _dbGetValueWithKey:key];
-        } break;
-        case YYKVStorageTypeMixed: {
-            NSString *filename = [self _dbGetFilenameWithKey:key];
-            if (filename) {
-                value = [self _fileReadWithName:filename];
-                if (!value) {
-                    [self _dbDeleteItemWithKey:key];
-                    value = nil;
-                }
-            } else {
-                value = [self _dbGetValueWithKey:key];
-            }
-        } break;
+    NSString *filename = nil;
+    int64_t slabOffset = -1;
+    int slabSize = 0;
+    // 统一取整行，过期检查对所有存储类型一致
+    YYKVStorageItem *item = [self _dbGetItemWithKey:key excludeInlineData:NO];
+    if (item && item.expireTime > 0 && item.expireTime <= (int)time(NULL)) {
+        // 过期视作未命中，记录留给清扫回收
+        item = nil;
     }
-    if (value) {
-        [self _dbUpdateAccessTimeWithKey:key];
+    if (item) {
+        value = item.value;
+        filename = item.filename;
+        if (!filename && item.slabOffset >= 0) {
+            slabOffset = item.slabOffset;
+            slabSize = item.size;
+        }
+    }
+    pthread_mutex_unlock(&_dbLock);
+    
+    // 文件和slab的读取在db锁外进行，并发读取时互不阻塞
+    if (!value) {
+        if (filename) {
+            value = [self _fileReadWithName:filename];
+        } else if (slabOffset >= 0) {
+            value = [self _slabReadValueAtOffset:slabOffset size:slabSize];
+        }
+    }
+    if (!_readOnly) {
+        pthread_mutex_lock(&_dbLock);
+        if (value) {
+            [self _noteAccessWithKey:key];
+        } else if (filename || slabOffset >= 0) {
+            // 读取失败说明数据已损坏，删除记录
+            [self _dbDeleteItemWithKey:key];
+        }
+        pthread_mutex_unlock(&_dbLock);
     }
     return value;
 }
 
 - (NSArray *)getItemForKeys:(NSArray *)keys {
     if (keys.count == 0) return nil;
+    pthread_mutex_lock(&_dbLock);
     NSMutableArray *items = [self _dbGetItemWithKeys:keys excludeInlineData:NO];
+    if (items.count > 0 && !_readOnly) {
+        [self _noteAccessWithKeys:keys];
+    }
+    pthread_mutex_unlock(&_dbLock);
+    int timestamp = (int)time(NULL);
+    for (NSInteger i = 0, max = items.count; i < max; i++) {
+        YYKVStorageItem *item = items[i];
+        if (item.expireTime > 0 && item.expireTime <= timestamp) {
+            // 过期视作未命中，记录留给清扫回收
+            [items removeObjectAtIndex:i];
+            i--;
+            max--;
+        }
+    }
     if (_type != YYKVStorageTypeSQLite) {
+        // 文件和slab的读取在db锁外进行，读取失败的记录批量删除
+        NSMutableArray *brokenKeys = nil;
         for (NSInteger i = 0, max = items.count; i < max; i++) {
             YYKVStorageItem *item = items[i];
             if (item.filename) {
                 item.value = [self _fileReadWithName:item.filename];
-                if (!item.value) {
-                    if (item.key) [self _dbDeleteItemWithKey:item.key];
-                    [items removeObjectAtIndex:i];
-                    i--;
-                    max--;
+            } else if (item.slabOffset >= 0 && !item.value) {
+                item.value = [self _slabReadValueAtOffset:item.slabOffset size:item.size];
+            }
+            if (!item.value) {
+                if (item.key) {
+                    if (!brokenKeys) brokenKeys = [NSMutableArray new];
+                    [brokenKeys addObject:item.key];
                 }
+                [items removeObjectAtIndex:i];
+                i--;
+                max--;
             }
         }
+        if (brokenKeys.count > 0 && !_readOnly) {
+            pthread_mutex_lock(&_dbLock);
+            [self _dbDeleteItemWithKeys:brokenKeys];
+            pthread_mutex_unlock(&_dbLock);
+        }
     }
-    if (items.count > 0) {
-        [self _dbUpdateAccessTimeWithKeys:keys];
+    return items.count ? items : nil;
+}
+
+- (NSArray *)getItemsOrderByAccessTimeDescWithLimit:(int)limit {
+    if (limit <= 0) return nil;
+    pthread_mutex_lock(&_dbLock);
+    // 先把积攒的访问时间落库，排序才能反映最近的读取
+    [self _flushAccessTimeUpdatesLocked];
+    NSMutableArray *items = [self _dbGetItemsOrderByAccessTimeDescWithLimit:limit];
+    pthread_mutex_unlock(&_dbLock);
+    if (_type != YYKVStorageTypeSQLite) {
+        // 文件和slab的读取在db锁外进行，读取失败的记录直接跳过（留给清扫处理）
+        for (NSInteger i = 0, max = items.count; i < max; i++) {
+            YYKVStorageItem *item = items[i];
+            if (item.filename) {
+                item.value = [self _fileReadWithName:item.filename];
+            } else if (item.slabOffset >= 0 && !item.value) {
+                item.value = [self _slabReadValueAtOffset:item.slabOffset size:item.size];
+            }
+            if (!item.value) {
+                [items removeObjectAtIndex:i];
+                i--;
+                max--;
+            }
+        }
     }
     return items.count ? items : nil;
 }
 
+- (void)enumerateItemsOrderByAccessTimeAscUsingBlock:(void (^)(YYKVStorageItem *item, BOOL *stop))block {
+    if (!block) return;
+    NSString *sql = @"select key, filename, size, inline_data, modification_time, last_access_time, extended_data, slab_offset, expire_time from manifest where (expire_time is null or expire_time <= 0 or expire_time > strftime('%s','now')) order by last_access_time asc;";
+    pthread_mutex_lock(&_dbLock);
+    if (![self _dbCheck]) {
+        pthread_mutex_unlock(&_dbLock);
+        return;
+    }
+    // 先把积攒的访问时间落库，遍历顺序才能反映最近的读取
+    [self _flushAccessTimeUpdatesLocked];
+    // 游标要跨批次保持打开，不能用可复用的缓存stmt，这里单独prepare一份
+    sqlite3_stmt *stmt = NULL;
+    int result = sqlite3_prepare_v2(_db, sql.UTF8String, -1, &stmt, NULL);
+    if (result != SQLITE_OK) {
+        if (_errorLogsEnabled) NSLog(@"%s line:%d sqlite stmt prepare error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+        pthread_mutex_unlock(&_dbLock);
+        return;
+    }
+    pthread_mutex_unlock(&_dbLock);
+
+    const int perCount = 32;
+    BOOL stop = NO, finished = NO;
+    do {
+        NSMutableArray *items = [NSMutableArray new];
+        pthread_mutex_lock(&_dbLock);
+        for (int i = 0; i < perCount; i++) {
+            result = sqlite3_step(stmt);
+            if (result == SQLITE_ROW) {
+                YYKVStorageItem *item = [self _dbGetItemFromStmt:stmt excludeInlineData:NO];
+                if (item) [items addObject:item];
+            } else {
+                if (result != SQLITE_DONE && _errorLogsEnabled) NSLog(@"%s line:%d sqlite query error (%d): %s", __FUNCTION__, __LINE__, result, sqlite3_errmsg(_db));
+                finished = YES;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&_dbLock);
+
+        for (YYKVStorageItem *item in items) {
+            if (_type != YYKVStorageTypeSQLite) {
+                // 文件和slab的读取在db锁外进行，读取失败的记录直接跳过（留给清扫处理）
+                if (item.filename) {
+                    item.value = [self _fileReadWithName:item.filename];
+                } else if (item.slabOffset >= 0 && !item.value) {
+                    item.value = [self _slabReadValueAtOffset:item.slabOffset size:item.size];
+                }
+                if (!item.value) continue;
+            }
+            block(item, &stop);
+            if (stop) break;
+        }
+    } while (!stop && !finished);
+
+    pthread_mutex_lock(&_dbLock);
+    sqlite3_finalize(stmt);
+    pthread_mutex_unlock(&_dbLock);
+}
+
 - (NSArray *)getItemInfoForKeys:(NSArray *)keys {
     if (keys.count == 0) return nil;
-    return [self _dbGetItemWithKeys:keys excludeInlineData:YES];
+    pthread_mutex_lock(&_dbLock);
+    NSMutableArray *items = [self _dbGetItemWithKeys:keys excludeInlineData:YES];
+    pthread_mutex_unlock(&_dbLock);
+    int timestamp = (int)time(NULL);
+    for (NSInteger i = 0, max = items.count; i < max; i++) {
+        YYKVStorageItem *item = items[i];
+        if (item.expireTime > 0 && item.expireTime <= timestamp) {
+            [items removeObjectAtIndex:i];
+            i--;
+            max--;
+        }
+    }
+    return items;
 }
 
 - (NSDictionary *)getItemValueForKeys:(NSArray *)keys {
@@ -1216,15 +2340,93 @@ static UIApplication *_YYSharedApplication() {
 
 - (BOOL)itemExistsForKey:(NSString *)key {
     if (key.length == 0) return NO;
-    return [self _dbGetItemCountWithKey:key] > 0;
+    pthread_mutex_lock(&_dbLock);
+    BOOL exists = [self _keyIndexMayContainKey:key] && [self _dbGetItemCountWithKey:key] > 0;
+    pthread_mutex_unlock(&_dbLock);
+    return exists;
 }
 
 - (int)getItemsCount {
-    return [self _dbGetTotalItemCount];
+    pthread_mutex_lock(&_dbLock);
+    int count = [self _dbGetTotalItemCount];
+    pthread_mutex_unlock(&_dbLock);
+    return count;
 }
 
 - (int)getItemsSize {
-    return [self _dbGetTotalItemSize];
+    pthread_mutex_lock(&_dbLock);
+    int size = [self _dbGetTotalItemSize];
+    pthread_mutex_unlock(&_dbLock);
+    return size;
+}
+
+- (void)flushAccessTimeUpdates {
+    pthread_mutex_lock(&_dbLock);
+    [self _flushAccessTimeUpdatesLocked];
+    pthread_mutex_unlock(&_dbLock);
+}
+
+- (BOOL)performMaintenanceIfNeeded {
+    if (_readOnly) return NO;
+    BOOL needed = NO;
+    // wal文件过大说明checkpoint落后了，读取要同时扫描wal和主库
+    NSString *walPath = [_dbPath stringByAppendingString:@"-wal"];
+    NSDictionary *attrs = [[NSFileManager defaultManager] attributesOfItemAtPath:walPath error:NULL];
+    if ([attrs fileSize] > kMaintenanceWALSizeThreshold) needed = YES;
+    // 大量删除之后统计信息过时，查询计划会退化
+    if (_dbDeletesSinceMaintenance >= kMaintenanceDeleteCountThreshold) needed = YES;
+    if (!needed) return NO;
+    [self performMaintenance];
+    return YES;
+}
+
+- (void)performMaintenance {
+    if (_readOnly) return;
+    if (![self _dbCheck]) return;
+    NSTimeInterval opBegin = CFAbsoluteTimeGetCurrent();
+    YYKVStorageSignpostBegin("dbMaintenance");
+    // 合并wal到主库并截断wal文件，长期运行的安装不再积累几十MB的wal
+    sqlite3_wal_checkpoint_v2(_db, NULL, SQLITE_CHECKPOINT_TRUNCATE, NULL, NULL);
+    // 空闲页超过总页数的1/4时整理文件，回收删除留下的空间
+    int64_t freelistCount = [self _dbGetInt64WithSql:@"pragma freelist_count;"];
+    int64_t pageCount = [self _dbGetInt64WithSql:@"pragma page_count;"];
+    if (pageCount > 0 && freelistCount * 4 >= pageCount) {
+        [self _dbExecute:@"vacuum;"];
+    }
+    // 重建统计信息，之后重置删除计数
+    if (_dbDeletesSinceMaintenance > 0) {
+        [self _dbExecute:@"analyze;"];
+        _dbDeletesSinceMaintenance = 0;
+    }
+    // 持久化画像学到的inline阈值，重启后不用从头学习
+    NSUInteger recommended = [self _ioProfileRecommendation];
+    if (recommended > 0 && recommended != _learnedInlineThreshold) {
+        if ([self _dbSetMetaValue:recommended forKey:kMetaKeyInlineThreshold]) {
+            _learnedInlineThreshold = recommended;
+        }
+    }
+    YYKVStorageSignpostEnd("dbMaintenance");
+    [self _recordOp:"dbMaintenance" keyLength:0 bytes:0 begin:opBegin];
+}
+
+- (NSArray *)slowOperations {
+    NSMutableArray *ops = [NSMutableArray new];
+    pthread_mutex_lock(&_slowOpLock);
+    NSUInteger total = _slowOpIndex;
+    NSUInteger count = total < kSlowOpRingCapacity ? total : kSlowOpRingCapacity;
+    for (NSUInteger i = 0; i < count; i++) {
+        // 从最旧的一条开始按时间顺序导出
+        _YYKVStorageSlowOpRecord *record = &_slowOps[(total - count + i) % kSlowOpRingCapacity];
+        YYKVStorageSlowOp *op = [YYKVStorageSlowOp new];
+        op.operation = [NSString stringWithUTF8String:record->operation];
+        op.keyLength = record->keyLength;
+        op.bytes = record->bytes;
+        op.duration = record->duration;
+        op.timestamp = record->timestamp;
+        [ops addObject:op];
+    }
+    pthread_mutex_unlock(&_slowOpLock);
+    return ops;
 }
 
 @end
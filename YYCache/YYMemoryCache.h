@@ -13,19 +13,49 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ The admission policy that decides whether a new key is allowed into the cache
+ when it is full.
+ 缓存已满时决定新key是否允许写入的准入策略
+ */
+typedef NS_ENUM(NSUInteger, YYMemoryCacheAdmissionPolicy) {
+    /// Every set is admitted, eviction alone enforces the limits (default).
+    /// 所有写入直接进入缓存，仅靠淘汰维持上限（默认）
+    YYMemoryCacheAdmissionPolicyNone = 0,
+
+    /// TinyLFU: a compact frequency sketch tracks key popularity, and when a
+    /// shard is full a new key is only admitted if its estimated frequency is
+    /// higher than that of the entry it would evict. Makes the cache
+    /// scan-resistant: one-shot bulk reads cannot flush the hot working set.
+    /// TinyLFU：用紧凑的频率草图统计key的热度，分片满时新key的估计频率
+    /// 高于待淘汰项才允许写入，一次性的批量扫描不会冲掉热点数据
+    YYMemoryCacheAdmissionPolicyTinyLFU = 1,
+};
+
+/**
+ A snapshot of the counters maintained by a memory cache. See `statistics`.
+ 内存缓存运行计数的快照，见 `statistics`
+ */
+typedef struct YYMemoryCacheStatistics {
+    uint64_t hitCount;      ///< Lookups that returned a value. 返回了对象的查询次数
+    uint64_t missCount;     ///< Lookups that returned nothing. 未返回对象的查询次数（过期视作未命中）
+    uint64_t evictionCount; ///< Entries removed by the cost/count/age limits. 因限制被淘汰的对象数
+    uint64_t expiredCount;  ///< Entries reclaimed because their TTL passed. 因TTL过期被回收的对象数
+} YYMemoryCacheStatistics;
+
 /**
  YYMemoryCache is a fast in-memory cache that stores key-value pairs.
  In contrast to NSDictionary, keys are retained and not copied.
  The API and performance is similar to `NSCache`, all methods are thread-safe.
- 
+
  YYMemoryCache objects differ from NSCache in a few ways:
- 
+
  * It uses LRU (least-recently-used) to remove objects; NSCache's eviction method
    is non-deterministic.
  * It can be controlled by cost, count and age; NSCache's limits are imprecise.
- * It can be configured to automatically evict objects when receive memory 
+ * It can be configured to automatically evict objects when receive memory
    warning or app enter background.
- 
+
  The time of `Access Methods` in YYMemoryCache is typically in constant time (O(1)).
  */
 @interface YYMemoryCache : NSObject
@@ -53,6 +83,23 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly) NSUInteger totalCost;
 
+/**
+ The number of independent shards the cache uses internally (read-only).
+ Default is 1.
+
+ @discussion Each shard holds its own linked map guarded by its own lock, and a
+ key is hashed to exactly one shard. With more than one shard, concurrent access
+ from multiple threads no longer serializes on a single mutex, so throughput
+ scales with the number of cores for read-heavy workloads. Use
+ `initWithShardCount:` to create a sharded cache.
+
+ cache 内部独立分片的数量（只读），默认为1
+ 每个分片持有独立的链表map和互斥锁，key 通过 hash 落到唯一的分片
+ 分片数大于1时，多线程并发访问不再竞争同一把锁，多核下吞吐量可随核数提升
+ 使用 `initWithShardCount:` 创建分片的 cache
+ */
+@property (readonly) NSUInteger shardCount;
+
 
 #pragma mark - Limit
 ///=============================================================================
@@ -109,6 +156,39 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property NSTimeInterval autoTrimInterval;
 
+/**
+ If `YES`, the periodic trim timer is stopped and trimming is triggered by the
+ set operations instead. The default value is `NO`.
+
+ @discussion With the timer, the cache wakes the CPU every `autoTrimInterval`
+ seconds even when it is completely idle, and a write burst can overshoot the
+ limits for up to a full interval. In event-driven mode a set only schedules a
+ background trim when the shard crosses `trimHighWaterRatio` of its limit, and
+ the trim evicts down to `trimLowWaterRatio` so small fluctuations around the
+ limit do not retrigger it. An idle cache costs nothing. Note that in this mode
+ `ageLimit` and expired entries are only reclaimed when a trim is triggered by
+ a write (reads still treat them as misses).
+
+ 如果是 YES 则停止定时轮询，改为由写入触发清扫，默认值是 NO
+ 定时器即使在缓存完全空闲时也会周期性唤醒CPU，而写入突发则可能超限长达一个周期
+ 事件驱动模式下只有写入使分片越过高水位（trimHighWaterRatio）才安排一次后台清扫
+ 清到低水位（trimLowWaterRatio）为止，限制附近的小幅波动不会反复触发，空闲时零开销
+ 注意此模式下 `ageLimit` 和过期对象只在写入触发清扫时回收（读取仍然视为未命中）
+ */
+@property BOOL eventDrivenTrimEnabled;
+
+/**
+ The fraction of a limit that triggers an event-driven trim. Default is 1.0.
+ 触发事件驱动清扫的高水位比例，默认值是 1.0
+ */
+@property double trimHighWaterRatio;
+
+/**
+ The fraction of a limit that an event-driven trim evicts down to. Default is 0.8.
+ 事件驱动清扫的低水位比例，清扫进行到该比例为止，默认值是 0.8
+ */
+@property double trimLowWaterRatio;
+
 /**
  If `YES`, the cache will remove all objects when the app receives a memory warning.
  The default value is `YES`.
@@ -118,6 +198,36 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property BOOL shouldRemoveAllObjectsOnMemoryWarning;
 
+/**
+ If `YES`, a memory warning triggers a partial trim instead of a full flush.
+ The default value is `NO`.
+
+ @discussion A full flush makes every recovery after a warning worst-case: the
+ whole UI pays cold-cache latency and re-decodes content the cache still had
+ room for. With this property set, the first warning trims the cache down to
+ `memoryWarningTrimRatio` of `costLimit` (of the current total cost when no
+ cost limit is set), keeping the hottest head of the LRU list. Only a second
+ warning arriving within 30 seconds — a sign that memory is still tight —
+ empties the cache completely. When `YES`, this property takes precedence over
+ `shouldRemoveAllObjectsOnMemoryWarning`.
+
+ 如果是 YES 内存警告时只做部分削减而不是全部清空，默认值是 NO
+ 全部清空意味着每次警告后整个UI都要承受冷缓存的延迟，重新解码本来还放得下的内容
+ 开启后第一次警告削减到 costLimit 的 `memoryWarningTrimRatio`（未设置costLimit时
+ 按当前总开销的该比例），保住LRU链表头部的热点数据
+ 30秒内的第二次警告说明内存依然紧张，此时才全部清空
+ 此属性为 YES 时优先于 `shouldRemoveAllObjectsOnMemoryWarning`
+ */
+@property BOOL gradualTrimOnMemoryWarning;
+
+/**
+ The fraction of `costLimit` that a memory warning trims down to when
+ `gradualTrimOnMemoryWarning` is `YES`. Default is 0.25.
+ 内存警告时削减到 costLimit 的比例（gradualTrimOnMemoryWarning 为 YES 时生效）
+ 默认值是 0.25
+ */
+@property double memoryWarningTrimRatio;
+
 /**
  If `YES`, The cache will remove all objects when the app enter background.
  The default value is `YES`.
@@ -143,6 +253,64 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nullable, copy) void(^didEnterBackgroundBlock)(YYMemoryCache *cache);
 
+/**
+ If `YES`, a cache hit only marks the object as accessed instead of moving it
+ to the head of the LRU list. The default value is `NO`.
+
+ @discussion With the default LRU policy, every `objectForKey:` relinks the
+ node and refreshes its access time while holding the lock, which turns pure
+ reads into writes. When this property is `YES`, a hit only sets a reference
+ bit on the node (CLOCK style), and the reordering happens lazily during the
+ trim passes: a tail node with its reference bit set gets a second chance and
+ is rotated back to the head instead of being evicted. This makes the hit path
+ near-read-only, at the price of a slightly less exact LRU order. Note that
+ with this mode the `ageLimit` is measured from the last write or the last
+ second-chance rotation, not from the last read.
+
+ 如果是 YES 命中时只在节点上设置引用位，不再每次命中都把节点移到链表头部
+ 列表的重排延迟到清扫时进行：尾部节点引用位被置位时获得二次机会旋转回头部（CLOCK算法）
+ 读多写少的场景可以大幅降低命中路径的开销，代价是LRU顺序不再精确
+ 注意此模式下 `ageLimit` 从最后一次写入或二次机会旋转算起，而不是最后一次读取
+ 默认值是 NO
+ */
+@property BOOL defersRecencyUpdates;
+
+/**
+ The admission policy applied on set operations.
+ The default value is `YYMemoryCacheAdmissionPolicyNone`.
+
+ @discussion With `YYMemoryCacheAdmissionPolicyTinyLFU`, every read and write
+ records the key in a per-shard frequency sketch (a few KB of counters that are
+ periodically halved so stale history ages out). A set into a full shard is
+ rejected when the new key is estimated to be colder than the tail victim, so
+ the hot working set survives large one-time scans at the same cost/count
+ limits. Switching the policy resets the sketch.
+
+ set操作使用的准入策略，默认值是 `YYMemoryCacheAdmissionPolicyNone`
+ TinyLFU模式下每次读写都会在分片的频率草图中记录key（几KB的计数器，定期减半衰减）
+ 写入已满的分片时，新key的估计热度低于尾部待淘汰项则被拒绝
+ 大批量的一次性扫描不会把热点工作集冲出缓存，切换策略会重置草图
+ */
+@property (nonatomic) YYMemoryCacheAdmissionPolicy admissionPolicy;
+
+/**
+ If `YES`, evicted objects are tracked in a per-shard weak-value ghost table.
+ The default value is NO.
+
+ @discussion When a node is evicted for capacity, its object is often still
+ retained elsewhere (e.g. by a visible view). With the ghost tier enabled,
+ `objectForKey:` checks the ghost table after a miss and re-admits the object
+ if it is still alive, skipping the disk round trip and deserialization. The
+ table holds the objects weakly, so it never extends their lifetime; dead
+ entries are purged by NSMapTable. Explicitly removed keys are not revived.
+
+ 如果是 YES 被容量淘汰的对象会进入分片的弱引用ghost表，默认值是 NO
+ 被淘汰的对象经常还被别处（如正在显示的view）持有着
+ 未命中时检查ghost表，对象还存活就直接复活，省掉磁盘往返和反序列化
+ 表对对象是弱引用，不会延长其生命周期；显式删除的key不会被复活
+ */
+@property (nonatomic) BOOL ghostTierEnabled;
+
 /**
  If `YES`, the key-value pair will be released on main thread, otherwise on
  background thread. Default is NO.
@@ -166,6 +334,32 @@ NS_ASSUME_NONNULL_BEGIN
 @property BOOL releaseAsynchronously;
 
 
+#pragma mark - Initializer
+///=============================================================================
+/// @name Initializer
+///=============================================================================
+
+/**
+ Create a new cache with the specified number of shards.
+
+ @param shardCount The number of independent shards. Pass 0 or 1 to get the
+     default single-shard behavior. The count, cost and age limits are applied
+     across all shards, and trim runs per-shard.
+ @return A new cache object.
+
+ @discussion A shard count around the number of CPU cores is a good choice when
+ the cache is hammered from many threads at once. Note that the per-shard limits
+ are `limit / shardCount`, so the eviction order is LRU within each shard
+ instead of globally.
+
+ 创建一个指定分片数量的 cache
+ shardCount 独立分片的数量，传 0 或 1 表示默认的单分片行为
+ count、cost 和 age 的限制作用于所有分片的总和，清扫按分片执行
+ 多线程高并发访问时，分片数量接近CPU核数是比较好的选择
+ 注意每个分片的限制为 `limit / shardCount`，LRU的淘汰顺序是分片内有序而非全局有序
+ */
+- (instancetype)initWithShardCount:(NSUInteger)shardCount NS_DESIGNATED_INITIALIZER;
+
 #pragma mark - Access Methods
 ///=============================================================================
 /// @name Access Methods
@@ -229,10 +423,86 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setObject:(nullable id)object forKey:(id)key withCost:(NSUInteger)cost;
 
 /**
- Removes the value of the specified key in the cache.
+ Sets the value of the specified key in the cache with a time-to-live.
  
- @param key The key identifying the value to be removed. If nil, this method has no effect.
+ @param object The object to store in the cache. If nil, it calls `removeObjectForKey`.
+ @param key    The key with which to associate the value. If nil, this method has no effect.
+ @param cost   The cost with which to associate the key-value pair.
+ @param ttl    Seconds until the entry expires. 0 or a negative value means no expiry.
+ @discussion Expiration is lazy: an expired entry is treated as a miss by the
+ access methods and reclaimed by the periodic trim pass, so no extra timer is
+ kept per entry. Setting the key again resets (or clears) its ttl.
  
+ 根据指定的key、开销cost和存活时间ttl存储消息
+ object 需要存储到池子的对象. 如果是nil则调用 `removeObjectForKey`.
+ key 存储对象关联的key. 如果是nil则不执行任何操作
+ cost 关联键值对的开销
+ ttl  过期秒数，0或负值表示不过期
+ 过期采用惰性回收：访问时过期的消息当作未命中，真正的移除由周期清扫完成
+ 不需要为每条消息维护额外的定时器；再次写入同一key会重置（或清除）ttl
+ */
+- (void)setObject:(nullable id)object forKey:(id)key withCost:(NSUInteger)cost ttl:(NSTimeInterval)ttl;
+
+/**
+ Sets a speculatively loaded value without marking it recently used.
+
+ @param object The object to store in the cache. If nil, this method has no effect.
+ @param key    The key with which to associate the value. If nil, this method has no effect.
+ @param cost   The cost with which to associate the key-value pair.
+
+ @discussion The entry is inserted at the cold (LRU) end of the list instead of
+ the head, so a prefetched value that is never actually read is the first to be
+ evicted and cannot displace the existing hot working set. If the key is
+ already cached, its value and position are left untouched. Used by
+ `YYCache.prefetchObjectsForKeys:`.
+
+ 写入一个预取的消息对象，但不把它标记为最近使用
+ 节点插入到链表的冷端（LRU端）而不是头部：预取后从未被真正读取的对象会最先被淘汰
+ 不会把已有的热点工作集挤出缓存。key已存在时保持原value和位置不动
+ 供 `YYCache.prefetchObjectsForKeys:` 使用
+ */
+- (void)setPrefetchedObject:(nullable id)object forKey:(nullable id)key withCost:(NSUInteger)cost;
+
+/**
+ Returns the values associated with the given keys.
+
+ @param keys An array of objects identifying the values. If empty, just return
+     an empty dictionary.
+ @return A dictionary containing the keys found in the cache and their values.
+     Keys with no associated value are simply absent from the result.
+
+ @discussion The lock of each shard is taken only once for all the keys mapped
+ to it, so fetching a batch of keys is much cheaper than calling
+ `objectForKey:` in a loop.
+
+ 批量获取一组key关联的消息对象
+ keys key的数组，如果为空则返回空字典
+ 返回命中的key和消息对象组成的字典，未命中的key不会出现在结果中
+ 每个分片的锁对落到该分片的所有key只获取一次，比循环调用 `objectForKey:` 开销低很多
+ */
+- (NSDictionary *)objectsForKeys:(NSArray *)keys;
+
+/**
+ Sets the values of the specified keys in the cache (0 cost).
+
+ @param objects An array of objects to be stored in the cache.
+ @param keys    An array of keys, must have the same count as `objects`.
+
+ @discussion The lock of each shard is taken only once for all the keys mapped
+ to it, and the count/cost limits are checked once per shard after the batch.
+
+ 批量存储一组键值对（开销为0）
+ objects 需要存储到池子的对象数组
+ keys    关联的key数组，数量必须和 `objects` 一致
+ 每个分片的锁只获取一次，数量/开销限制在整批写入后检查一次
+ */
+- (void)setObjects:(NSArray *)objects forKeys:(NSArray *)keys;
+
+/**
+ Removes the value of the specified key in the cache.
+
+ @param key The key identifying the value to be removed. If nil, this method has no effect.
+
  根据指定的key删除消息
  key 需要删除的object的key. 如果是nil则不执行任何操作
  */
@@ -272,6 +542,31 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)trimToAge:(NSTimeInterval)age;
 
+#pragma mark - Statistics
+///=============================================================================
+/// @name Statistics
+///=============================================================================
+
+/**
+ Returns a snapshot of the hit/miss/eviction/expiry counters.
+
+ @discussion The counters are maintained with relaxed atomic increments on the
+ access paths, so they are cheap enough to leave enabled in production. Counts
+ cover `objectForKey:` and `objectsForKeys:`; explicit removals are not counted
+ as evictions.
+
+ 返回命中/未命中/淘汰/过期计数的快照
+ 计数在访问路径上用relaxed原子自增维护，开销可以忽略，适合在线上常开
+ 只统计 `objectForKey:` 和 `objectsForKeys:`，显式删除不计入淘汰
+ */
+- (YYMemoryCacheStatistics)statistics;
+
+/**
+ Resets all statistics counters to zero.
+ 将所有统计计数清零
+ */
+- (void)resetStatistics;
+
 @end
 
 NS_ASSUME_NONNULL_END
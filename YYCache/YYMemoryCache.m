@@ -14,6 +14,14 @@
 #import <CoreFoundation/CoreFoundation.h>
 #import <QuartzCore/QuartzCore.h>
 #import <pthread.h>
+#import <stdatomic.h>
+
+static const NSUInteger kYYLinkedMapNodePoolCapacity = 256; /// 每个分片回收节点数量的上限
+
+static const NSUInteger kYYFreqSketchCounters = 1 << 16;    /// 每个分片的频率草图计数器个数（4个哈希位置共享）
+static const NSUInteger kYYFreqSketchSampleSize = (1 << 16) * 8;    /// 计数器整体减半前记录的访问次数
+
+static const NSTimeInterval kYYMemoryWarningConsecutiveInterval = 30.0; /// 两次内存警告间隔在此之内算作连续警告
 
 /// 获取release线程
 static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
@@ -33,6 +41,8 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
     id _value;  /// 消息
     NSUInteger _cost;   /// 消息开销
     NSTimeInterval _time;   /// 消息时间
+    NSTimeInterval _expireTime; /// 过期时间戳（CACurrentMediaTime基准），0表示不过期
+    BOOL _accessed; /// CLOCK引用位，延迟更新LRU时在命中路径置位
 }
 @end
 
@@ -43,9 +53,9 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
 /**
  A linked map used by YYMemoryCache.
  It's not thread-safe and does not validate the parameters.
- 
+
  Typically, you should not use this class directly.
- 
+
  非线程安全 && 未验证全部参数
  */
 @interface _YYLinkedMap : NSObject {
@@ -57,6 +67,11 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
     _YYLinkedMapNode *_tail; // LRU, do not change it directly LRU最近最少使用, 外部不要直接修改
     BOOL _releaseOnMainThread;  // 是否在主线程release
     BOOL _releaseAsynchronously;    // 是否异步release
+    NSMutableArray *_nodePool;  // 回收的空节点，避免热路径上反复分配
+    uint8_t *_freqSketch;   // TinyLFU频率草图，未启用时为NULL
+    NSUInteger _freqSketchOps;  // 草图记录的访问次数，达到采样上限时计数整体减半
+    NSMapTable *_ghosts;        // 弱引用的ghost表（被淘汰但还存活的对象），未启用时为nil
+    NSMapTable *_ghostCosts;    // ghost对象->淘汰时cost，对象为弱key，随对象死亡自动清理
 }
 
 /// Insert a node at head and update the total cost.
@@ -65,6 +80,12 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
 /// node 节点 && node的key不能为nil
 - (void)insertNodeAtHead:(_YYLinkedMapNode *)node;
 
+/// Insert a node at the tail (LRU end) and update the total cost.
+/// Node and node.key should not be nil.
+/// 在尾部（LRU端）插入一个节点node
+/// node 节点 && node的key不能为nil
+- (void)insertNodeAtTail:(_YYLinkedMapNode *)node;
+
 /// Bring a inner node to header.
 /// Node should already inside the dic.
 /// 将字典中的节点移至头部
@@ -82,10 +103,63 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
 /// 返回删除的节点
 - (_YYLinkedMapNode *)removeTailNode;
 
+/// Remove the tail node, giving recently accessed nodes a second chance.
+/// A tail node with the `_accessed` bit set is rotated to the head (bit
+/// cleared, time refreshed) instead of being removed, CLOCK style.
+/// 删除尾部节点，被访问过的节点获得二次机会（CLOCK算法）
+/// 尾部节点的引用位被置位时，清除引用位并旋转到头部，而不是删除
+- (_YYLinkedMapNode *)removeTailNodeWithSecondChance;
+
+/// Return a recycled node from the pool, or nil if the pool is empty.
+/// 从回收池取出一个空节点，池子为空时返回nil
+- (nullable _YYLinkedMapNode *)dequeueNodeFromPool;
+
+/// Strip a removed node's key/value into the holder (for release in a
+/// specified queue) and recycle the empty node shell into the bounded pool.
+/// 将已删除节点的key/value转移到holder（由指定队列release），空节点壳回收进池子
+- (void)recycleNode:(_YYLinkedMapNode *)node intoHolder:(NSMutableArray *)holder;
+
 /// Remove all node in background queue.
 /// 在后台线程删除所有的节点
 - (void)removeAll;
 
+/// Allocate (or reset) the frequency sketch used by the TinyLFU admission policy.
+/// 分配（或重置）TinyLFU准入策略使用的频率草图
+- (void)enableFrequencySketch;
+
+/// Free the frequency sketch.
+/// 释放频率草图
+- (void)disableFrequencySketch;
+
+/// Record one access to the key in the frequency sketch (4 counters, count-min style).
+/// When the sample size is reached, all counters are halved so stale history ages out.
+/// 在频率草图中记录一次key的访问（count-min方式的4个计数器）
+/// 达到采样上限时所有计数器减半，使过时的历史逐渐衰减
+- (void)recordAccessForKey:(id)key;
+
+/// The estimated access frequency of the key (minimum over its 4 counters).
+/// key的估计访问频率（4个计数器的最小值）
+- (NSUInteger)frequencyForKey:(id)key;
+
+/// Allocate the weak-value ghost table used to revive evicted objects.
+/// 分配用于复活被淘汰对象的弱引用ghost表
+- (void)enableGhostTier;
+
+/// Drop the ghost table.
+/// 丢弃ghost表
+- (void)disableGhostTier;
+
+/// Move an evicted node's key/value into the ghost table (no-op when disabled).
+/// 把被淘汰节点的key/value移入ghost表（未启用时为空操作）
+- (void)addGhostForNode:(_YYLinkedMapNode *)node;
+
+/// Take the still-alive ghost object for the key, or nil.
+/// The entry is removed from the table on a hit; the object's original cost
+/// is returned through `cost` so revival keeps the costLimit accounting honest.
+/// 取出key对应的仍然存活的ghost对象，没有则返回nil；命中时顺带移除表项
+/// 对象被淘汰时的cost通过 `cost` 带回，复活后costLimit的记账不失真
+- (nullable id)takeGhostForKey:(id)key cost:(NSUInteger *)cost;
+
 @end
 
 @implementation _YYLinkedMap
@@ -98,11 +172,13 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
     _dic = CFDictionaryCreateMutable(CFAllocatorGetDefault(), 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
     _releaseOnMainThread = NO;
     _releaseAsynchronously = YES;
+    _nodePool = [NSMutableArray new];
     return self;
 }
 
 - (void)dealloc {
     CFRelease(_dic);
+    if (_freqSketch) free(_freqSketch);
 }
 
 - (void)insertNodeAtHead:(_YYLinkedMapNode *)node {
@@ -118,9 +194,22 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
     }
 }
 
+- (void)insertNodeAtTail:(_YYLinkedMapNode *)node {
+    CFDictionarySetValue(_dic, (__bridge const void *)(node->_key), (__bridge const void *)(node));
+    _totalCost += node->_cost;
+    _totalCount++;
+    if (_tail) {
+        node->_prev = _tail;
+        _tail->_next = node;
+        _tail = node;
+    } else {
+        _head = _tail = node;
+    }
+}
+
 - (void)bringNodeToHead:(_YYLinkedMapNode *)node {
     if (_head == node) return;
-    
+
     if (_tail == node) {
         _tail = node->_prev;
         _tail->_next = nil;
@@ -159,15 +248,124 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
     return tail;
 }
 
+- (_YYLinkedMapNode *)removeTailNodeWithSecondChance {
+    if (!_tail) return nil;
+    NSUInteger rotation = _totalCount;
+    while (rotation-- > 0 && _tail->_accessed) {
+        _tail->_accessed = NO;
+        _tail->_time = CACurrentMediaTime();
+        [self bringNodeToHead:_tail];
+    }
+    return [self removeTailNode];
+}
+
+- (_YYLinkedMapNode *)dequeueNodeFromPool {
+    _YYLinkedMapNode *node = _nodePool.lastObject;
+    if (node) [_nodePool removeLastObject];
+    return node;
+}
+
+- (void)recycleNode:(_YYLinkedMapNode *)node intoHolder:(NSMutableArray *)holder {
+    if (!node) return;
+    if (node->_key) [holder addObject:node->_key];
+    if (node->_value) [holder addObject:node->_value];
+    node->_key = nil;
+    node->_value = nil;
+    node->_prev = nil;
+    node->_next = nil;
+    node->_cost = 0;
+    node->_expireTime = 0;
+    node->_accessed = NO;
+    if (_nodePool.count < kYYLinkedMapNodePoolCapacity) [_nodePool addObject:node];
+}
+
+- (void)enableFrequencySketch {
+    if (!_freqSketch) _freqSketch = calloc(kYYFreqSketchCounters, sizeof(uint8_t));
+    _freqSketchOps = 0;
+}
+
+- (void)disableFrequencySketch {
+    if (_freqSketch) {
+        free(_freqSketch);
+        _freqSketch = NULL;
+    }
+    _freqSketchOps = 0;
+}
+
+/**
+ 用一个64位混合哈希的4个16位切片作为4个计数器下标
+ */
+static inline uint64_t _YYFreqSketchHash(id key) {
+    return (uint64_t)[key hash] * 0x9E3779B97F4A7C15UL;
+}
+
+- (void)recordAccessForKey:(id)key {
+    if (!_freqSketch || !key) return;
+    uint64_t hash = _YYFreqSketchHash(key);
+    for (int i = 0; i < 4; i++) {
+        NSUInteger idx = (hash >> (i * 16)) & (kYYFreqSketchCounters - 1);
+        if (_freqSketch[idx] < UINT8_MAX) _freqSketch[idx]++;
+    }
+    if (++_freqSketchOps >= kYYFreqSketchSampleSize) {
+        // 采样上限：所有计数器减半，历史热度逐渐衰减
+        for (NSUInteger i = 0; i < kYYFreqSketchCounters; i++) {
+            _freqSketch[i] >>= 1;
+        }
+        _freqSketchOps /= 2;
+    }
+}
+
+- (NSUInteger)frequencyForKey:(id)key {
+    if (!_freqSketch || !key) return 0;
+    uint64_t hash = _YYFreqSketchHash(key);
+    NSUInteger freq = NSUIntegerMax;
+    for (int i = 0; i < 4; i++) {
+        NSUInteger idx = (hash >> (i * 16)) & (kYYFreqSketchCounters - 1);
+        if (_freqSketch[idx] < freq) freq = _freqSketch[idx];
+    }
+    return freq;
+}
+
+- (void)enableGhostTier {
+    if (!_ghosts) _ghosts = [NSMapTable strongToWeakObjectsMapTable];
+    // cost表以对象为弱key，对象死亡时条目自动清理
+    if (!_ghostCosts) _ghostCosts = [NSMapTable weakToStrongObjectsMapTable];
+}
+
+- (void)disableGhostTier {
+    _ghosts = nil;
+    _ghostCosts = nil;
+}
+
+- (void)addGhostForNode:(_YYLinkedMapNode *)node {
+    if (!_ghosts || !node || !node->_key || !node->_value) return;
+    [_ghosts setObject:node->_value forKey:node->_key];
+    if (node->_cost) [_ghostCosts setObject:@(node->_cost) forKey:node->_value];
+}
+
+- (id)takeGhostForKey:(id)key cost:(NSUInteger *)cost {
+    if (cost) *cost = 0;
+    if (!_ghosts || !key) return nil;
+    id object = [_ghosts objectForKey:key];
+    if (object) {
+        [_ghosts removeObjectForKey:key];
+        if (cost) *cost = [[_ghostCosts objectForKey:object] unsignedIntegerValue];
+        [_ghostCosts removeObjectForKey:object];
+    }
+    return object;
+}
+
 - (void)removeAll {
     _totalCost = 0;
     _totalCount = 0;
     _head = nil;
     _tail = nil;
+    if (_ghosts) [_ghosts removeAllObjects];
+    if (_ghostCosts) [_ghostCosts removeAllObjects];
     if (CFDictionaryGetCount(_dic) > 0) {
         CFMutableDictionaryRef holder = _dic;
         _dic = CFDictionaryCreateMutable(CFAllocatorGetDefault(), 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
-        
+
         if (_releaseAsynchronously) {
             dispatch_queue_t queue = _releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
             dispatch_async(queue, ^{
@@ -188,9 +386,36 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
 
 
 @implementation YYMemoryCache {
-    pthread_mutex_t _lock;
-    _YYLinkedMap *_lru;     /// 礼物消息存储的map
+    NSUInteger _shardCount;             /// 分片数量，默认为1
+    pthread_mutex_t *_locks;            /// 每个分片一个互斥锁
+    NSArray<_YYLinkedMap *> *_shards;   /// 礼物消息存储的map分片数组
     dispatch_queue_t _queue;
+    atomic_bool _trimScheduled;         /// 事件驱动模式下是否已经安排了一次后台清扫
+    NSTimeInterval _lastMemoryWarningTime;  /// 上一次内存警告的时间，用于识别连续警告
+
+    atomic_uint_fast64_t _hitCount;         /// 命中次数（relaxed原子计数，常开无感知开销）
+    atomic_uint_fast64_t _missCount;        /// 未命中次数
+    atomic_uint_fast64_t _evictionCount;    /// 因cost/count/age限制被淘汰的对象数
+    atomic_uint_fast64_t _expiredCount;     /// 因TTL过期被回收的对象数
+}
+
+/**
+ Hash the key to one of the shards.
+ 根据key的hash值获取分片下标
+ */
+- (NSUInteger)_shardIndexForKey:(id)key {
+    if (_shardCount == 1) return 0;
+    return (NSUInteger)[key hash] % _shardCount;
+}
+
+/**
+ Split a global limit into a per-shard limit.
+ 根据总限制计算每个分片的限制
+ */
+- (NSUInteger)_shardLimitForLimit:(NSUInteger)limit {
+    if (_shardCount == 1 || limit == 0 || limit == NSUIntegerMax) return limit;
+    NSUInteger shardLimit = limit / _shardCount;
+    return shardLimit > 0 ? shardLimit : 1;
 }
 
 /**
@@ -201,53 +426,131 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
     dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_autoTrimInterval * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
         __strong typeof(_self) self = _self;
         if (!self) return;
+        if (self->_eventDrivenTrimEnabled) return; // 事件驱动模式下停止轮询，空闲时不再唤醒CPU
         [self _trimInBackground];
         [self _trimRecursively];
     });
 }
 
+/**
+ 事件驱动清扫：写入使分片越过高水位时才安排一次后台清扫，清到低水位为止
+ 调用方必须已经持有分片的锁
+ */
+- (void)_scheduleTrimIfNeededForMap:(_YYLinkedMap *)lru {
+    NSUInteger costHigh = [self _shardLimitForLimit:_costLimit];
+    NSUInteger countHigh = [self _shardLimitForLimit:_countLimit];
+    if (costHigh != NSUIntegerMax) costHigh = (NSUInteger)(costHigh * _trimHighWaterRatio);
+    if (countHigh != NSUIntegerMax) countHigh = (NSUInteger)(countHigh * _trimHighWaterRatio);
+    if (lru->_totalCost <= costHigh && lru->_totalCount <= countHigh) return;
+    
+    BOOL expected = NO;
+    if (!atomic_compare_exchange_strong(&_trimScheduled, &expected, YES)) return; // 已有清扫在途
+    __weak typeof(self) _self = self;
+    dispatch_async(_queue, ^{
+        __strong typeof(_self) self = _self;
+        if (!self) return;
+        [self _trimExpired];
+        if (self->_costLimit != NSUIntegerMax) {
+            [self _trimToCost:(NSUInteger)(self->_costLimit * self->_trimLowWaterRatio)];
+        }
+        if (self->_countLimit != NSUIntegerMax) {
+            [self _trimToCount:(NSUInteger)(self->_countLimit * self->_trimLowWaterRatio)];
+        }
+        // 高低水位只针对cost/count，超龄的消息直接清到ageLimit
+        [self _trimToAge:self->_ageLimit];
+        atomic_store(&self->_trimScheduled, NO);
+    });
+}
+
 /**
  消息池子在后台清扫
  */
 - (void)_trimInBackground {
     dispatch_async(_queue, ^{
+        [self _trimExpired];
         [self _trimToCost:self->_costLimit];
         [self _trimToCount:self->_countLimit];
         [self _trimToAge:self->_ageLimit];
     });
 }
 
+/**
+ 清扫所有已过期的消息（惰性回收：过期消息在访问时只当作未命中，真正的移除在这里进行）
+ */
+- (void)_trimExpired {
+    NSTimeInterval now = CACurrentMediaTime();
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        _YYLinkedMap *lru = _shards[i];
+        NSMutableArray *holder = nil;
+        pthread_mutex_lock(&_locks[i]);
+        _YYLinkedMapNode *node = lru->_tail;
+        while (node) {
+            _YYLinkedMapNode *prev = node->_prev;
+            if (node->_expireTime > 0 && node->_expireTime <= now) {
+                [lru removeNode:node];
+                if (!holder) holder = [NSMutableArray new];
+                [lru recycleNode:node intoHolder:holder];
+                atomic_fetch_add_explicit(&_expiredCount, 1, memory_order_relaxed);
+            }
+            node = prev;
+        }
+        pthread_mutex_unlock(&_locks[i]);
+        if (holder.count) {
+            dispatch_queue_t queue = lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
+            dispatch_async(queue, ^{
+                [holder count]; // release in queue
+            });
+        }
+    }
+}
+
 /**
  消息池子在后台清扫
  */
 - (void)_trimToCost:(NSUInteger)costLimit {
+    NSUInteger shardLimit = [self _shardLimitForLimit:costLimit];
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        [self _trimShard:i toCost:shardLimit];
+    }
+}
+
+/**
+ 单个分片按照开销限制清扫
+ */
+- (void)_trimShard:(NSUInteger)shardIndex toCost:(NSUInteger)costLimit {
+    _YYLinkedMap *lru = _shards[shardIndex];
+    pthread_mutex_t *lock = &_locks[shardIndex];
     BOOL finish = NO;
-    pthread_mutex_lock(&_lock);
+    pthread_mutex_lock(lock);
     if (costLimit == 0) {
-        [_lru removeAll];
+        [lru removeAll];
         finish = YES;
-    } else if (_lru->_totalCost <= costLimit) {
+    } else if (lru->_totalCost <= costLimit) {
         finish = YES;
     }
-    pthread_mutex_unlock(&_lock);
+    pthread_mutex_unlock(lock);
     if (finish) return;
-    
+
     NSMutableArray *holder = [NSMutableArray new];
     while (!finish) {
-        if (pthread_mutex_trylock(&_lock) == 0) {
-            if (_lru->_totalCost > costLimit) {
-                _YYLinkedMapNode *node = [_lru removeTailNode];
-                if (node) [holder addObject:node];
+        if (pthread_mutex_trylock(lock) == 0) {
+            if (lru->_totalCost > costLimit) {
+                _YYLinkedMapNode *node = _defersRecencyUpdates ? [lru removeTailNodeWithSecondChance] : [lru removeTailNode];
+                if (node) {
+                    [lru addGhostForNode:node];
+                    [lru recycleNode:node intoHolder:holder];
+                    atomic_fetch_add_explicit(&_evictionCount, 1, memory_order_relaxed);
+                }
             } else {
                 finish = YES;
             }
-            pthread_mutex_unlock(&_lock);
+            pthread_mutex_unlock(lock);
         } else {
             usleep(10 * 1000); //10 ms
         }
     }
     if (holder.count) {
-        dispatch_queue_t queue = _lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
+        dispatch_queue_t queue = lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
         dispatch_async(queue, ^{
             [holder count]; // release in queue
         });
@@ -258,33 +561,49 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
  消息池子按照数量限制清扫
  */
 - (void)_trimToCount:(NSUInteger)countLimit {
+    NSUInteger shardLimit = [self _shardLimitForLimit:countLimit];
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        [self _trimShard:i toCount:shardLimit];
+    }
+}
+
+/**
+ 单个分片按照数量限制清扫
+ */
+- (void)_trimShard:(NSUInteger)shardIndex toCount:(NSUInteger)countLimit {
+    _YYLinkedMap *lru = _shards[shardIndex];
+    pthread_mutex_t *lock = &_locks[shardIndex];
     BOOL finish = NO;
-    pthread_mutex_lock(&_lock);
+    pthread_mutex_lock(lock);
     if (countLimit == 0) {
-        [_lru removeAll];
+        [lru removeAll];
         finish = YES;
-    } else if (_lru->_totalCount <= countLimit) {
+    } else if (lru->_totalCount <= countLimit) {
         finish = YES;
     }
-    pthread_mutex_unlock(&_lock);
+    pthread_mutex_unlock(lock);
     if (finish) return;
-    
+
     NSMutableArray *holder = [NSMutableArray new];
     while (!finish) {
-        if (pthread_mutex_trylock(&_lock) == 0) {
-            if (_lru->_totalCount > countLimit) {
-                _YYLinkedMapNode *node = [_lru removeTailNode];
-                if (node) [holder addObject:node];
+        if (pthread_mutex_trylock(lock) == 0) {
+            if (lru->_totalCount > countLimit) {
+                _YYLinkedMapNode *node = _defersRecencyUpdates ? [lru removeTailNodeWithSecondChance] : [lru removeTailNode];
+                if (node) {
+                    [lru addGhostForNode:node];
+                    [lru recycleNode:node intoHolder:holder];
+                    atomic_fetch_add_explicit(&_evictionCount, 1, memory_order_relaxed);
+                }
             } else {
                 finish = YES;
             }
-            pthread_mutex_unlock(&_lock);
+            pthread_mutex_unlock(lock);
         } else {
             usleep(10 * 1000); //10 ms
         }
     }
     if (holder.count) {
-        dispatch_queue_t queue = _lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
+        dispatch_queue_t queue = lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
         dispatch_async(queue, ^{
             [holder count]; // release in queue
         });
@@ -295,34 +614,48 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
  消息池子按照时间限制清扫
  */
 - (void)_trimToAge:(NSTimeInterval)ageLimit {
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        [self _trimShard:i toAge:ageLimit];
+    }
+}
+
+/**
+ 单个分片按照时间限制清扫
+ */
+- (void)_trimShard:(NSUInteger)shardIndex toAge:(NSTimeInterval)ageLimit {
+    _YYLinkedMap *lru = _shards[shardIndex];
+    pthread_mutex_t *lock = &_locks[shardIndex];
     BOOL finish = NO;
     NSTimeInterval now = CACurrentMediaTime();
-    pthread_mutex_lock(&_lock);
+    pthread_mutex_lock(lock);
     if (ageLimit <= 0) {
-        [_lru removeAll];
+        [lru removeAll];
         finish = YES;
-    } else if (!_lru->_tail || (now - _lru->_tail->_time) <= ageLimit) {
+    } else if (!lru->_tail || (now - lru->_tail->_time) <= ageLimit) {
         finish = YES;
     }
-    pthread_mutex_unlock(&_lock);
+    pthread_mutex_unlock(lock);
     if (finish) return;
-    
+
     NSMutableArray *holder = [NSMutableArray new];
     while (!finish) {
-        if (pthread_mutex_trylock(&_lock) == 0) {
-            if (_lru->_tail && (now - _lru->_tail->_time) > ageLimit) {
-                _YYLinkedMapNode *node = [_lru removeTailNode];
-                if (node) [holder addObject:node];
+        if (pthread_mutex_trylock(lock) == 0) {
+            if (lru->_tail && (now - lru->_tail->_time) > ageLimit) {
+                _YYLinkedMapNode *node = [lru removeTailNode];
+                if (node) {
+                    [lru recycleNode:node intoHolder:holder];
+                    atomic_fetch_add_explicit(&_evictionCount, 1, memory_order_relaxed);
+                }
             } else {
                 finish = YES;
             }
-            pthread_mutex_unlock(&_lock);
+            pthread_mutex_unlock(lock);
         } else {
             usleep(10 * 1000); //10 ms
         }
     }
     if (holder.count) {
-        dispatch_queue_t queue = _lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
+        dispatch_queue_t queue = lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
         dispatch_async(queue, ^{
             [holder count]; // release in queue
         });
@@ -333,6 +666,26 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
     if (self.didReceiveMemoryWarningBlock) {
         self.didReceiveMemoryWarningBlock(self);
     }
+    if (_gradualTrimOnMemoryWarning) {
+        // 第一次警告只削减到costLimit的一部分，保住链表头部的热点数据
+        // 短时间内的第二次警告说明内存依然紧张，此时才全部清空
+        NSTimeInterval now = CACurrentMediaTime();
+        BOOL consecutive = _lastMemoryWarningTime > 0 && (now - _lastMemoryWarningTime) <= kYYMemoryWarningConsecutiveInterval;
+        _lastMemoryWarningTime = now;
+        if (consecutive) {
+            [self removeAllObjects];
+            return;
+        }
+        NSUInteger base = _costLimit != NSUIntegerMax ? _costLimit : self.totalCost;
+        NSUInteger target = (NSUInteger)(base * _memoryWarningTrimRatio);
+        __weak typeof(self) _self = self;
+        dispatch_async(_queue, ^{
+            __strong typeof(_self) self = _self;
+            if (!self) return;
+            [self trimToCost:target];
+        });
+        return;
+    }
     if (self.shouldRemoveAllObjectsOnMemoryWarning) {
         [self removeAllObjects];
     }
@@ -350,21 +703,35 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
 #pragma mark - public
 
 - (instancetype)init {
+    return [self initWithShardCount:1];
+}
+
+- (instancetype)initWithShardCount:(NSUInteger)shardCount {
     self = super.init;
-    pthread_mutex_init(&_lock, NULL);   /// 初始化 pthread_mutex_t
-    _lru = [_YYLinkedMap new];
+    if (shardCount == 0) shardCount = 1;
+    _shardCount = shardCount;
+    _locks = malloc(sizeof(pthread_mutex_t) * shardCount);  /// 初始化每个分片的 pthread_mutex_t
+    NSMutableArray *shards = [NSMutableArray arrayWithCapacity:shardCount];
+    for (NSUInteger i = 0; i < shardCount; i++) {
+        pthread_mutex_init(&_locks[i], NULL);
+        [shards addObject:[_YYLinkedMap new]];
+    }
+    _shards = shards.copy;
     _queue = dispatch_queue_create("com.ibireme.cache.memory", DISPATCH_QUEUE_SERIAL);
-    
+
     _countLimit = NSUIntegerMax;
     _costLimit = NSUIntegerMax;
     _ageLimit = DBL_MAX;
     _autoTrimInterval = 5.0;
+    _trimHighWaterRatio = 1.0;
+    _trimLowWaterRatio = 0.8;
     _shouldRemoveAllObjectsOnMemoryWarning = YES;
+    _memoryWarningTrimRatio = 0.25;
     _shouldRemoveAllObjectsWhenEnteringBackground = YES;
-    
+
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(_appDidReceiveMemoryWarningNotification) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(_appDidEnterBackgroundNotification) name:UIApplicationDidEnterBackgroundNotification object:nil];
-    
+
     [self _trimRecursively];
     return self;
 }
@@ -372,67 +739,129 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
 - (void)dealloc {
     [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidEnterBackgroundNotification object:nil];
-    [_lru removeAll];
-    pthread_mutex_destroy(&_lock);
+    for (_YYLinkedMap *lru in _shards) {
+        [lru removeAll];
+    }
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        pthread_mutex_destroy(&_locks[i]);
+    }
+    free(_locks);
+}
+
+- (NSUInteger)shardCount {
+    return _shardCount;
 }
 
 - (NSUInteger)totalCount {
-    pthread_mutex_lock(&_lock);
-    NSUInteger count = _lru->_totalCount;
-    pthread_mutex_unlock(&_lock);
+    NSUInteger count = 0;
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        pthread_mutex_lock(&_locks[i]);
+        count += _shards[i]->_totalCount;
+        pthread_mutex_unlock(&_locks[i]);
+    }
     return count;
 }
 
 - (NSUInteger)totalCost {
-    pthread_mutex_lock(&_lock);
-    NSUInteger totalCost = _lru->_totalCost;
-    pthread_mutex_unlock(&_lock);
+    NSUInteger totalCost = 0;
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        pthread_mutex_lock(&_locks[i]);
+        totalCost += _shards[i]->_totalCost;
+        pthread_mutex_unlock(&_locks[i]);
+    }
     return totalCost;
 }
 
 - (BOOL)releaseOnMainThread {
-    pthread_mutex_lock(&_lock);
-    BOOL releaseOnMainThread = _lru->_releaseOnMainThread;
-    pthread_mutex_unlock(&_lock);
+    pthread_mutex_lock(&_locks[0]);
+    BOOL releaseOnMainThread = _shards[0]->_releaseOnMainThread;
+    pthread_mutex_unlock(&_locks[0]);
     return releaseOnMainThread;
 }
 
 - (void)setReleaseOnMainThread:(BOOL)releaseOnMainThread {
-    pthread_mutex_lock(&_lock);
-    _lru->_releaseOnMainThread = releaseOnMainThread;
-    pthread_mutex_unlock(&_lock);
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        pthread_mutex_lock(&_locks[i]);
+        _shards[i]->_releaseOnMainThread = releaseOnMainThread;
+        pthread_mutex_unlock(&_locks[i]);
+    }
 }
 
 - (BOOL)releaseAsynchronously {
-    pthread_mutex_lock(&_lock);
-    BOOL releaseAsynchronously = _lru->_releaseAsynchronously;
-    pthread_mutex_unlock(&_lock);
+    pthread_mutex_lock(&_locks[0]);
+    BOOL releaseAsynchronously = _shards[0]->_releaseAsynchronously;
+    pthread_mutex_unlock(&_locks[0]);
     return releaseAsynchronously;
 }
 
 - (void)setReleaseAsynchronously:(BOOL)releaseAsynchronously {
-    pthread_mutex_lock(&_lock);
-    _lru->_releaseAsynchronously = releaseAsynchronously;
-    pthread_mutex_unlock(&_lock);
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        pthread_mutex_lock(&_locks[i]);
+        _shards[i]->_releaseAsynchronously = releaseAsynchronously;
+        pthread_mutex_unlock(&_locks[i]);
+    }
 }
 
 - (BOOL)containsObjectForKey:(id)key {
     if (!key) return NO;
-    pthread_mutex_lock(&_lock);
-    BOOL contains = CFDictionaryContainsKey(_lru->_dic, (__bridge const void *)(key));
-    pthread_mutex_unlock(&_lock);
+    NSUInteger shardIndex = [self _shardIndexForKey:key];
+    _YYLinkedMap *lru = _shards[shardIndex];
+    pthread_mutex_lock(&_locks[shardIndex]);
+    _YYLinkedMapNode *node = CFDictionaryGetValue(lru->_dic, (__bridge const void *)(key));
+    BOOL contains = node && !(node->_expireTime > 0 && node->_expireTime <= CACurrentMediaTime());
+    pthread_mutex_unlock(&_locks[shardIndex]);
     return contains;
 }
 
 - (id)objectForKey:(id)key {
     if (!key) return nil;
-    pthread_mutex_lock(&_lock);
-    _YYLinkedMapNode *node = CFDictionaryGetValue(_lru->_dic, (__bridge const void *)(key));
+    NSUInteger shardIndex = [self _shardIndexForKey:key];
+    _YYLinkedMap *lru = _shards[shardIndex];
+    pthread_mutex_lock(&_locks[shardIndex]);
+    if (_admissionPolicy == YYMemoryCacheAdmissionPolicyTinyLFU) [lru recordAccessForKey:key];
+    _YYLinkedMapNode *node = CFDictionaryGetValue(lru->_dic, (__bridge const void *)(key));
+    if (node && node->_expireTime > 0 && node->_expireTime <= CACurrentMediaTime()) {
+        // 过期视作未命中，顺手移除节点
+        [lru removeNode:node];
+        NSMutableArray *holder = [NSMutableArray new];
+        [lru recycleNode:node intoHolder:holder];
+        if (lru->_releaseAsynchronously) {
+            dispatch_queue_t queue = lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
+            dispatch_async(queue, ^{
+                [holder count]; //hold and release in queue
+            });
+        } else if (lru->_releaseOnMainThread && !pthread_main_np()) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [holder count]; //hold and release in queue
+            });
+        }
+        node = nil;
+        atomic_fetch_add_explicit(&_expiredCount, 1, memory_order_relaxed);
+    }
+    if (!node) {
+        // ghost命中：对象还被别处（如正在显示的view）持有着
+        // 直接复活省掉整个磁盘往返和反序列化
+        NSUInteger ghostCost = 0;
+        id ghost = [lru takeGhostForKey:key cost:&ghostCost];
+        if (ghost) {
+            [self _setObject:ghost forKey:key withCost:ghostCost ttl:0 inMap:lru];
+            if (_eventDrivenTrimEnabled) [self _scheduleTrimIfNeededForMap:lru];
+            pthread_mutex_unlock(&_locks[shardIndex]);
+            atomic_fetch_add_explicit(&_hitCount, 1, memory_order_relaxed);
+            return ghost;
+        }
+    }
     if (node) {
-        node->_time = CACurrentMediaTime();
-        [_lru bringNodeToHead:node];
+        if (_defersRecencyUpdates) {
+            // 命中只设置引用位，列表的重排延迟到清扫时进行
+            node->_accessed = YES;
+        } else {
+            node->_time = CACurrentMediaTime();
+            [lru bringNodeToHead:node];
+        }
     }
-    pthread_mutex_unlock(&_lock);
+    pthread_mutex_unlock(&_locks[shardIndex]);
+    atomic_fetch_add_explicit(node ? &_hitCount : &_missCount, 1, memory_order_relaxed);
     return node ? node->_value : nil;
 }
 
@@ -440,75 +869,323 @@ static inline dispatch_queue_t YYMemoryCacheGetReleaseQueue() {
     [self setObject:object forKey:key withCost:0];
 }
 
-- (void)setObject:(id)object forKey:(id)key withCost:(NSUInteger)cost {
-    if (!key) return;
-    if (!object) {
-        [self removeObjectForKey:key];
-        return;
+- (YYMemoryCacheStatistics)statistics {
+    YYMemoryCacheStatistics stats;
+    stats.hitCount = atomic_load_explicit(&_hitCount, memory_order_relaxed);
+    stats.missCount = atomic_load_explicit(&_missCount, memory_order_relaxed);
+    stats.evictionCount = atomic_load_explicit(&_evictionCount, memory_order_relaxed);
+    stats.expiredCount = atomic_load_explicit(&_expiredCount, memory_order_relaxed);
+    return stats;
+}
+
+- (void)resetStatistics {
+    atomic_store_explicit(&_hitCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_missCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_evictionCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_expiredCount, 0, memory_order_relaxed);
+}
+
+- (void)setEventDrivenTrimEnabled:(BOOL)eventDrivenTrimEnabled {
+    BOOL wasEnabled = _eventDrivenTrimEnabled;
+    _eventDrivenTrimEnabled = eventDrivenTrimEnabled;
+    if (wasEnabled && !eventDrivenTrimEnabled) {
+        [self _trimRecursively]; // 恢复定时轮询
+    } else if (!wasEnabled && eventDrivenTrimEnabled) {
+        [self _trimInBackground]; // 切换时先清到限制以下
+    }
+}
+
+- (void)setGhostTierEnabled:(BOOL)ghostTierEnabled {
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        pthread_mutex_lock(&_locks[i]);
+        if (ghostTierEnabled) {
+            [_shards[i] enableGhostTier];
+        } else {
+            [_shards[i] disableGhostTier];
+        }
+        pthread_mutex_unlock(&_locks[i]);
+    }
+    _ghostTierEnabled = ghostTierEnabled;
+}
+
+- (void)setAdmissionPolicy:(YYMemoryCacheAdmissionPolicy)admissionPolicy {
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        pthread_mutex_lock(&_locks[i]);
+        if (admissionPolicy == YYMemoryCacheAdmissionPolicyTinyLFU) {
+            [_shards[i] enableFrequencySketch];
+        } else {
+            [_shards[i] disableFrequencySketch];
+        }
+        pthread_mutex_unlock(&_locks[i]);
     }
-    pthread_mutex_lock(&_lock);
-    _YYLinkedMapNode *node = CFDictionaryGetValue(_lru->_dic, (__bridge const void *)(key));
+    _admissionPolicy = admissionPolicy;
+}
+
+/**
+ TinyLFU admission: when the shard is full, a new key may only displace the
+ tail victim if its estimated frequency is higher. The shard's lock must be
+ held by the caller.
+ TinyLFU准入判断：分片已满时，新key的估计频率高于待淘汰的victim才允许写入
+ 扫描型的一次性访问频率很低，会被拒之门外而不是冲掉热点
+ 调用方必须已经持有分片的锁
+ */
+- (BOOL)_admitKey:(id)key inMap:(_YYLinkedMap *)lru {
+    if (CFDictionaryContainsKey(lru->_dic, (__bridge const void *)(key))) return YES; // 更新已有key
+    // 数量和开销都没到分片上限才算未满（只配置costLimit的cache同样要走准入判断）
+    if (lru->_totalCount < [self _shardLimitForLimit:_countLimit] &&
+        lru->_totalCost < [self _shardLimitForLimit:_costLimit]) return YES;
+    _YYLinkedMapNode *victim = lru->_tail;
+    if (!victim || !victim->_key) return YES;
+    return [lru frequencyForKey:key] > [lru frequencyForKey:victim->_key];
+}
+
+/**
+ Core of the set operation, the shard's lock must be held by the caller.
+ set操作的核心逻辑，调用方必须已经持有分片的锁
+ */
+- (void)_setObject:(id)object forKey:(id)key withCost:(NSUInteger)cost ttl:(NSTimeInterval)ttl inMap:(_YYLinkedMap *)lru {
+    _YYLinkedMapNode *node = CFDictionaryGetValue(lru->_dic, (__bridge const void *)(key));
     NSTimeInterval now = CACurrentMediaTime();
+    NSTimeInterval expireTime = ttl > 0 ? now + ttl : 0;
     if (node) {
-        _lru->_totalCost -= node->_cost;
-        _lru->_totalCost += cost;
+        lru->_totalCost -= node->_cost;
+        lru->_totalCost += cost;
         node->_cost = cost;
         node->_time = now;
+        node->_expireTime = expireTime;
         node->_value = object;
-        [_lru bringNodeToHead:node];
+        [lru bringNodeToHead:node];
     } else {
-        node = [_YYLinkedMapNode new];
+        node = [lru dequeueNodeFromPool] ?: [_YYLinkedMapNode new];
         node->_cost = cost;
         node->_time = now;
+        node->_expireTime = expireTime;
         node->_key = key;
         node->_value = object;
-        [_lru insertNodeAtHead:node];
+        [lru insertNodeAtHead:node];
+    }
+}
+
+- (void)setObject:(id)object forKey:(id)key withCost:(NSUInteger)cost {
+    [self setObject:object forKey:key withCost:cost ttl:0];
+}
+
+- (void)setObject:(id)object forKey:(id)key withCost:(NSUInteger)cost ttl:(NSTimeInterval)ttl {
+    if (!key) return;
+    if (!object) {
+        [self removeObjectForKey:key];
+        return;
+    }
+    NSUInteger shardIndex = [self _shardIndexForKey:key];
+    _YYLinkedMap *lru = _shards[shardIndex];
+    pthread_mutex_lock(&_locks[shardIndex]);
+    if (_admissionPolicy == YYMemoryCacheAdmissionPolicyTinyLFU) {
+        [lru recordAccessForKey:key];
+        if (![self _admitKey:key inMap:lru]) {
+            pthread_mutex_unlock(&_locks[shardIndex]);
+            return;
+        }
     }
-    if (_lru->_totalCost > _costLimit) {
+    [self _setObject:object forKey:key withCost:cost ttl:ttl inMap:lru];
+    if (_eventDrivenTrimEnabled) {
+        [self _scheduleTrimIfNeededForMap:lru];
+        pthread_mutex_unlock(&_locks[shardIndex]);
+        return;
+    }
+    if (lru->_totalCost > [self _shardLimitForLimit:_costLimit]) {
         dispatch_async(_queue, ^{
-            [self trimToCost:_costLimit];
+            [self trimToCost:self->_costLimit];
         });
     }
-    if (_lru->_totalCount > _countLimit) {
-        _YYLinkedMapNode *node = [_lru removeTailNode];
-        if (_lru->_releaseAsynchronously) {
-            dispatch_queue_t queue = _lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
-            dispatch_async(queue, ^{
-                [node class]; //hold and release in queue
+    if (lru->_totalCount > [self _shardLimitForLimit:_countLimit]) {
+        _YYLinkedMapNode *node = _defersRecencyUpdates ? [lru removeTailNodeWithSecondChance] : [lru removeTailNode];
+        if (node) {
+            atomic_fetch_add_explicit(&_evictionCount, 1, memory_order_relaxed);
+            [lru addGhostForNode:node];
+            NSMutableArray *holder = [NSMutableArray new];
+            [lru recycleNode:node intoHolder:holder];
+            if (lru->_releaseAsynchronously) {
+                dispatch_queue_t queue = lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
+                dispatch_async(queue, ^{
+                    [holder count]; //hold and release in queue
+                });
+            } else if (lru->_releaseOnMainThread && !pthread_main_np()) {
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    [holder count]; //hold and release in queue
+                });
+            }
+        }
+    }
+    pthread_mutex_unlock(&_locks[shardIndex]);
+}
+
+- (void)setPrefetchedObject:(id)object forKey:(id)key withCost:(NSUInteger)cost {
+    if (!key || !object) return;
+    NSUInteger shardIndex = [self _shardIndexForKey:key];
+    _YYLinkedMap *lru = _shards[shardIndex];
+    pthread_mutex_lock(&_locks[shardIndex]);
+    // key已存在时保持原value和位置不动，预取不应该提升或覆盖已有条目
+    if (CFDictionaryContainsKey(lru->_dic, (__bridge const void *)(key))) {
+        pthread_mutex_unlock(&_locks[shardIndex]);
+        return;
+    }
+    if (_admissionPolicy == YYMemoryCacheAdmissionPolicyTinyLFU && ![self _admitKey:key inMap:lru]) {
+        pthread_mutex_unlock(&_locks[shardIndex]);
+        return;
+    }
+    _YYLinkedMapNode *node = [lru dequeueNodeFromPool] ?: [_YYLinkedMapNode new];
+    node->_cost = cost;
+    node->_time = CACurrentMediaTime();
+    node->_expireTime = 0;
+    node->_key = key;
+    node->_value = object;
+    // 插入冷端：从未被真正读取的预取对象最先被淘汰
+    [lru insertNodeAtTail:node];
+    if (_eventDrivenTrimEnabled) {
+        [self _scheduleTrimIfNeededForMap:lru];
+        pthread_mutex_unlock(&_locks[shardIndex]);
+        return;
+    }
+    BOOL overCost = lru->_totalCost > [self _shardLimitForLimit:_costLimit];
+    BOOL overCount = lru->_totalCount > [self _shardLimitForLimit:_countLimit];
+    pthread_mutex_unlock(&_locks[shardIndex]);
+    if (overCost || overCount) {
+        dispatch_async(_queue, ^{
+            [self trimToCost:self->_costLimit];
+            [self trimToCount:self->_countLimit];
+        });
+    }
+}
+
+- (NSDictionary *)objectsForKeys:(NSArray *)keys {
+    if (keys.count == 0) return [NSDictionary dictionary];
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        _YYLinkedMap *lru = _shards[i];
+        BOOL locked = NO;
+        for (id key in keys) {
+            if ([self _shardIndexForKey:key] != i) continue;
+            if (!locked) {
+                pthread_mutex_lock(&_locks[i]);
+                locked = YES;
+            }
+            if (_admissionPolicy == YYMemoryCacheAdmissionPolicyTinyLFU) [lru recordAccessForKey:key];
+            _YYLinkedMapNode *node = CFDictionaryGetValue(lru->_dic, (__bridge const void *)(key));
+            if (node) {
+                if (node->_expireTime > 0 && node->_expireTime <= CACurrentMediaTime()) {
+                    // 过期视作未命中，节点留给清扫回收
+                    atomic_fetch_add_explicit(&_expiredCount, 1, memory_order_relaxed);
+                    atomic_fetch_add_explicit(&_missCount, 1, memory_order_relaxed);
+                    continue;
+                }
+                if (_defersRecencyUpdates) {
+                    node->_accessed = YES;
+                } else {
+                    node->_time = CACurrentMediaTime();
+                    [lru bringNodeToHead:node];
+                }
+                result[key] = node->_value;
+                atomic_fetch_add_explicit(&_hitCount, 1, memory_order_relaxed);
+            } else {
+                // ghost命中：对象还存活，直接复活
+                NSUInteger ghostCost = 0;
+                id ghost = [lru takeGhostForKey:key cost:&ghostCost];
+                if (ghost) {
+                    [self _setObject:ghost forKey:key withCost:ghostCost ttl:0 inMap:lru];
+                    result[key] = ghost;
+                    atomic_fetch_add_explicit(&_hitCount, 1, memory_order_relaxed);
+                } else {
+                    atomic_fetch_add_explicit(&_missCount, 1, memory_order_relaxed);
+                }
+            }
+        }
+        if (locked) pthread_mutex_unlock(&_locks[i]);
+    }
+    return result;
+}
+
+- (void)setObjects:(NSArray *)objects forKeys:(NSArray *)keys {
+    if (objects.count != keys.count || keys.count == 0) return;
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        _YYLinkedMap *lru = _shards[i];
+        BOOL locked = NO;
+        for (NSUInteger k = 0, max = keys.count; k < max; k++) {
+            id key = keys[k];
+            if ([self _shardIndexForKey:key] != i) continue;
+            if (!locked) {
+                pthread_mutex_lock(&_locks[i]);
+                locked = YES;
+            }
+            if (_admissionPolicy == YYMemoryCacheAdmissionPolicyTinyLFU) {
+                [lru recordAccessForKey:key];
+                if (![self _admitKey:key inMap:lru]) continue;
+            }
+            [self _setObject:objects[k] forKey:key withCost:0 ttl:0 inMap:lru];
+        }
+        if (!locked) continue;
+        if (_eventDrivenTrimEnabled) {
+            [self _scheduleTrimIfNeededForMap:lru];
+            pthread_mutex_unlock(&_locks[i]);
+            continue;
+        }
+        // 整个分片写入完成后只检查一次限制
+        NSMutableArray *holder = nil;
+        NSUInteger shardCountLimit = [self _shardLimitForLimit:_countLimit];
+        while (lru->_totalCount > shardCountLimit) {
+            _YYLinkedMapNode *node = _defersRecencyUpdates ? [lru removeTailNodeWithSecondChance] : [lru removeTailNode];
+            if (!node) break;
+            [lru addGhostForNode:node];
+            if (!holder) holder = [NSMutableArray new];
+            [lru recycleNode:node intoHolder:holder];
+            atomic_fetch_add_explicit(&_evictionCount, 1, memory_order_relaxed);
+        }
+        BOOL overCost = lru->_totalCost > [self _shardLimitForLimit:_costLimit];
+        pthread_mutex_unlock(&_locks[i]);
+        if (overCost) {
+            dispatch_async(_queue, ^{
+                [self trimToCost:self->_costLimit];
             });
-        } else if (_lru->_releaseOnMainThread && !pthread_main_np()) {
-            dispatch_async(dispatch_get_main_queue(), ^{
-                [node class]; //hold and release in queue
+        }
+        if (holder.count) {
+            dispatch_queue_t queue = lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
+            dispatch_async(queue, ^{
+                [holder count]; // release in queue
             });
         }
     }
-    pthread_mutex_unlock(&_lock);
 }
 
 - (void)removeObjectForKey:(id)key {
     if (!key) return;
-    pthread_mutex_lock(&_lock);
-    _YYLinkedMapNode *node = CFDictionaryGetValue(_lru->_dic, (__bridge const void *)(key));
+    NSUInteger shardIndex = [self _shardIndexForKey:key];
+    _YYLinkedMap *lru = _shards[shardIndex];
+    pthread_mutex_lock(&_locks[shardIndex]);
+    if (lru->_ghosts) [lru->_ghosts removeObjectForKey:key]; // 显式删除的key不应从ghost表复活
+    _YYLinkedMapNode *node = CFDictionaryGetValue(lru->_dic, (__bridge const void *)(key));
     if (node) {
-        [_lru removeNode:node];
-        if (_lru->_releaseAsynchronously) {
-            dispatch_queue_t queue = _lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
+        [lru removeNode:node];
+        NSMutableArray *holder = [NSMutableArray new];
+        [lru recycleNode:node intoHolder:holder];
+        if (lru->_releaseAsynchronously) {
+            dispatch_queue_t queue = lru->_releaseOnMainThread ? dispatch_get_main_queue() : YYMemoryCacheGetReleaseQueue();
             dispatch_async(queue, ^{
-                [node class]; //hold and release in queue
+                [holder count]; //hold and release in queue
             });
-        } else if (_lru->_releaseOnMainThread && !pthread_main_np()) {
+        } else if (lru->_releaseOnMainThread && !pthread_main_np()) {
             dispatch_async(dispatch_get_main_queue(), ^{
-                [node class]; //hold and release in queue
+                [holder count]; //hold and release in queue
             });
         }
     }
-    pthread_mutex_unlock(&_lock);
+    pthread_mutex_unlock(&_locks[shardIndex]);
 }
 
 - (void)removeAllObjects {
-    pthread_mutex_lock(&_lock);
-    [_lru removeAll];
-    pthread_mutex_unlock(&_lock);
+    for (NSUInteger i = 0; i < _shardCount; i++) {
+        pthread_mutex_lock(&_locks[i]);
+        [_shards[i] removeAll];
+        pthread_mutex_unlock(&_locks[i]);
+    }
 }
 
 - (void)trimToCount:(NSUInteger)count {